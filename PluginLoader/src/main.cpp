@@ -1,11 +1,5 @@
 #include <PluginCore/Core>
-
-#include <csignal>
-#include <cerrno>
-#include <cstring>
-#include <unistd.h>  
-
-static volatile sig_atomic_t g_stop = 0;
+#include <PluginCore/EventLoop>
 
 //////////////////////////////////Backtrace
 #include <execinfo.h>
@@ -13,14 +7,6 @@ static volatile sig_atomic_t g_stop = 0;
 #include <stdio.h>
 #include <stdlib.h>
 
-void sig_handler(int num)
-{
-    static int count = 0;
-    count++;
-    if (count < 2) g_stop = 1;
-    else exit(0);    
-}
-
 void printBacktrace(int signal)
 {
     (void)signal;
@@ -39,14 +25,9 @@ void printBacktrace(int signal)
 
 
 int main(int argc, char* argv[]) {
-    struct sigaction sig;
-    sig.sa_handler  = sig_handler;
-    sig.sa_flags    = SA_NOCLDWAIT;
-    sig.sa_restorer = NULL;
-    sigaction(SIGINT, &sig, NULL);
-    sigaction(SIGTERM, &sig, NULL);
     signal(SIGSEGV, printBacktrace);
+    // SIGINT/SIGTERM/SIGHUP are read by the Core event loop; block them before any plugin thread starts
+    d3156::PluginCore::EventLoop::blockSignals();
     d3156::PluginCore::Core core(argc, argv);
-    while (!g_stop) pause(); 
-    return 0;
+    return core.run();
 }
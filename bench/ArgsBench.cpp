@@ -0,0 +1,60 @@
+/// Args::Builder: регистрация и разбор командной строки с сотнями аргументов
+#include "Bench.hpp"
+#include <ArgsBuilder/Builder.hpp>
+#include <deque>
+
+namespace
+{
+    /// Аргументы всех типов по четверти: int, double, std::string и флаги
+    struct Values {
+        std::deque<int> ints;
+        std::deque<double> doubles;
+        std::deque<std::string> strings;
+        std::deque<bool> flags;
+
+        explicit Values(const size_t count) : ints(count / 4), doubles(count / 4), strings(count / 4), flags(count / 4)
+        {
+        }
+
+        void registerArgs(d3156::Args::Builder &bldr)
+        {
+            for (size_t i = 0; i < ints.size(); ++i) {
+                const std::string n = std::to_string(i);
+                bldr.addOption(ints[i], "int-" + n, "integer option " + n)
+                    .addOption(doubles[i], "double-" + n, "floating option " + n)
+                    .addOption(strings[i], "string-" + n, "string option " + n)
+                    .addFlag(flags[i], "flag-" + n, "flag " + n);
+            }
+        }
+    };
+}
+
+void d3156::Bench::runArgsBenches(Report &report, const Options &)
+{
+    for (const size_t count : {100, 400}) {
+        std::vector<std::string> tokens = {"PluginCore_bench"};
+        for (size_t i = 0; i < count / 4; ++i) {
+            const std::string n = std::to_string(i);
+            tokens.insert(tokens.end(), {"--int-" + n, std::to_string(i * 7), "--double-" + n, "0." + n,
+                                         "--string-" + n, "value" + n, "--flag-" + n});
+        }
+        std::vector<char *> argv;
+        for (auto &token : tokens) argv.push_back(token.data());
+        const int argc = static_cast<int>(argv.size());
+        argv.push_back(nullptr);
+
+        Values values(count);
+        const size_t iterations = 200;
+        report.add("args/register_parse/" + std::to_string(count), nsPerOp(iterations, [&] {
+                       Args::Builder bldr;
+                       values.registerArgs(bldr);
+                       bldr.parse(argc, argv.data());
+                   }) / 1000,
+                   "us/op", iterations);
+
+        Args::Builder bldr;
+        values.registerArgs(bldr);
+        report.add("args/parse/" + std::to_string(count), nsPerOp(iterations, [&] { bldr.parse(argc, argv.data()); }) / 1000,
+                   "us/op", iterations);
+    }
+}
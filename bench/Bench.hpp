@@ -0,0 +1,76 @@
+#pragma once
+/// Общие средства набора бенчмарков PluginCore_bench: замер времени, сбор результатов, запуск дочерних процессов
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace d3156::Bench
+{
+    struct Result {
+        std::string name;
+        double value = 0;
+        std::string unit;
+        size_t iterations = 0;
+    };
+
+    /// \brief Результаты прогона. Повторный результат с тем же именем заменяет прежний, если он лучше (меньше)
+    class Report
+    {
+    public:
+        void add(const std::string &name, double value, const std::string &unit, size_t iterations);
+        /// \brief Строки "name\tvalue\tunit\titerations" - формат передачи из дочернего процесса
+        void parseLines(const std::string &text);
+        std::string lines() const;
+        std::string json() const;
+        const std::vector<Result> &results() const { return results_; }
+
+    private:
+        std::vector<Result> results_;
+    };
+
+    /// \brief Параметры прогона из командной строки
+    struct Options {
+        std::string filter;                           ///< Подстрока имени группы, пустая - все
+        std::vector<size_t> plugins = {10, 100, 1000}; ///< Число копий тестового плагина
+        size_t repeat               = 3;              ///< Запусков дочернего процесса на замер, берётся лучший
+        bool selected(const std::string &group) const { return filter.empty() || group.find(filter) != std::string::npos; }
+    };
+
+    template <class Fn> double nsPerOp(const size_t iterations, Fn &&fn)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) fn();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations);
+    }
+
+    /// \brief Не дать компилятору выбросить вычисление value
+    template <class T> inline void keep(const T &value) { asm volatile("" : : "r,m"(value) : "memory"); }
+
+    template <class Fn> double msOf(Fn &&fn)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /// \brief Запустить этот же исполняемый файл с "--child args..." и окружением env ("NAME=value"), вывод в
+    /// /dev/null. Результаты дочерний процесс пишет в дескриптор 3
+    /// \return false, если процесс завершился с ошибкой
+    bool runChild(const std::vector<std::string> &args, const std::vector<std::string> &env, Report &report);
+
+    /// \brief Временный каталог с count копиями тестового плагина
+    std::string makePluginsDir(size_t count);
+    void removeDir(const std::string &path);
+
+    void runLogFormatBenches(Report &report, const Options &options);
+    void runStorageBenches(Report &report, const Options &options);
+    void runArgsBenches(Report &report, const Options &options);
+    void runLogBenches(Report &report, const Options &options);
+    void runPluginsBenches(Report &report, const Options &options);
+
+    /// Точки входа дочерних процессов: "--child log ...", "--child core ...", "--child load ..."
+    int logChild(const std::vector<std::string> &args, Report &report);
+    int coreChild(const std::vector<std::string> &args, Report &report);
+    int loadChild(const std::vector<std::string> &args, Report &report);
+}
@@ -0,0 +1,21 @@
+/// Тестовый плагин набора бенчмарков: копируется N раз под именами libBench<i>.so. Все копии запрашивают одну модель
+#include <IPlugin.hpp>
+
+namespace
+{
+    struct BenchDummyModel final : d3156::PluginCore::IModel {
+        static std::string name() { return "BenchDummyModel_1.0:bench"; }
+        void init() override {}
+    };
+
+    struct BenchDummy final : d3156::PluginCore::IPlugin {
+        void registerModels(d3156::PluginCore::ModelsStorage &models) override
+        {
+            models.registerModel<BenchDummyModel>();
+        }
+    };
+}
+
+extern "C" d3156::PluginCore::IPlugin *create_plugin() { return new BenchDummy; }
+extern "C" void destroy_plugin(d3156::PluginCore::IPlugin *plugin) { delete plugin; }
+extern "C" const char *plugin_full_name() { return "BenchDummy_1.0:bench"; }
@@ -0,0 +1,73 @@
+/// Пропускная способность G_LOG в режимах вывода CONSOLE, FILE и PER_SOURCE_FILES в одном и нескольких потоках, а также
+/// цена сообщений, отброшенных выборкой (G_LOG_EVERY_N) и схлопыванием повторов.
+/// Режим логгера задаётся окружением при запуске процесса, поэтому каждый замер - отдельный дочерний процесс
+#include "Bench.hpp"
+#include <Logger/Log.hpp>
+#include <thread>
+
+namespace
+{
+    /// Четыре источника: в режиме PER_SOURCE_FILES у каждого свой файл
+#undef LOG_NAME
+#define LOG_NAME "BenchA"
+    void logA(const size_t i) { G_LOG(0, "Model registered success [Delete order " << i << "] BenchModel_1.0"); }
+#undef LOG_NAME
+#define LOG_NAME "BenchB"
+    void logB(const size_t i) { G_LOG(0, "Model registered success [Delete order " << i << "] BenchModel_1.0"); }
+#undef LOG_NAME
+#define LOG_NAME "BenchC"
+    void logC(const size_t i) { G_LOG(0, "Model registered success [Delete order " << i << "] BenchModel_1.0"); }
+#undef LOG_NAME
+#define LOG_NAME "BenchD"
+    void logD(const size_t i) { G_LOG(0, "Model registered success [Delete order " << i << "] BenchModel_1.0"); }
+
+    constexpr void (*sources[])(size_t) = {logA, logB, logC, logD};
+
+    /// Выводится одно сообщение из тысячи
+    void logSampled(const size_t i) { G_LOG_EVERY_N(0, 1000, "Downstream request " << i << " failed"); }
+    /// Одинаковые сообщения сводятся в "last message repeated N times"
+    void logRepeated(size_t) { G_LOG(0, "Downstream request failed"); }
+}
+
+int d3156::Bench::logChild(const std::vector<std::string> &args, Report &report)
+{
+    if (args.size() < 4) return 1;
+    const std::string &mode = args[1];
+    const size_t threads    = std::stoull(args[2]);
+    const size_t messages   = std::stoull(args[3]);
+    /// Прогрев: заголовок логгера и открытие файлов не входят в замер
+    for (const auto source : sources) source(0);
+    LoggerManager::flush();
+    void (*log)(size_t) = nullptr;
+    if (mode.ends_with("every_n")) log = logSampled;
+    if (mode.ends_with("repeated")) log = logRepeated;
+
+    const double ms = msOf([&] {
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t)
+            workers.emplace_back([&, t] {
+                for (size_t i = t; i < messages; i += threads) (log ? log : sources[i % 4])(i);
+            });
+        for (auto &worker : workers) worker.join();
+        LoggerManager::flush();
+    });
+    report.add("log/" + mode + "/" + std::to_string(threads) + "t", ms * 1e6 / static_cast<double>(messages),
+               "ns/msg", messages);
+    return 0;
+}
+
+void d3156::Bench::runLogBenches(Report &report, const Options &options)
+{
+    const std::string dir = makePluginsDir(0);
+    const std::pair<const char *, std::vector<std::string>> modes[] = {
+        {"console", {"OUT=CONSOLE", "PER_SOURCE_FILES=false", "LOG_MODE=SYNC"}},
+        {"file", {"OUT=FILE", "PER_SOURCE_FILES=false", "LOG_MODE=SYNC", "OUT_DIR=" + dir}},
+        {"per_source_files", {"OUT=FILE", "PER_SOURCE_FILES=true", "LOG_MODE=SYNC", "OUT_DIR=" + dir}},
+        {"console_every_n", {"OUT=CONSOLE", "PER_SOURCE_FILES=false", "LOG_MODE=SYNC"}},
+        {"console_repeated", {"OUT=CONSOLE", "PER_SOURCE_FILES=false", "LOG_MODE=SYNC", "LOG_REPEAT_MS=1000"}},
+    };
+    for (const auto &[mode, env] : modes)
+        for (const char *threads : {"1", "4"})
+            for (size_t r = 0; r < options.repeat; ++r) runChild({"log", mode, threads, "200000"}, env, report);
+    removeDir(dir);
+}
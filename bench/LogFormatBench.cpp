@@ -0,0 +1,66 @@
+/// Микробенчмарк форматирования строки лога: прежний вариант (regex + replace_all на каждую строку)
+/// против предварительно разобранного LogFormat.
+#include "Bench.hpp"
+#include <Logger/Format.hpp>
+#include <chrono>
+#include <cstring>
+#include <regex>
+#include <string>
+
+namespace
+{
+    using namespace d3156;
+
+    void replace_all(std::string &str, const std::string &from, const std::string &to)
+    {
+        size_t start = 0;
+        while ((start = str.find(from, start)) != std::string::npos) {
+            str.replace(start, from.length(), to);
+            start += to.length();
+        }
+    }
+
+    std::string legacyRender(const std::string &format, const LogRecord &rec)
+    {
+        std::string formatted = format;
+        std::regex date_regex(R"(\{date:(.*?)\})");
+        std::smatch match;
+        auto f_start = formatted.cbegin();
+        while (std::regex_search(f_start, formatted.cend(), match, date_regex)) {
+            auto t_c = std::chrono::system_clock::to_time_t(rec.time);
+            std::tm tm{};
+            localtime_r(&t_c, &tm);
+            char buf[64];
+            strftime(buf, sizeof(buf), match[1].str().c_str(), &tm);
+            formatted.replace(match.position(0), match.length(0), buf);
+            f_start = formatted.cbegin() + match.position(0) + std::strlen(buf);
+        }
+        replace_all(formatted, "{source}", std::string("GREEN_") + rec.source);
+        replace_all(formatted, "{file}", rec.file);
+        replace_all(formatted, "{line}", std::to_string(rec.line));
+        replace_all(formatted, "{message}", rec.message);
+        replace_all(formatted, "{level}", std::to_string(rec.level));
+        return formatted;
+    }
+}
+
+void d3156::Bench::runLogFormatBenches(Report &report, const Options &)
+{
+    const std::string format = "|{date:%Y-%m-%d %H:%M:%S}|{source}|{file}:{line}|{level}| {message}";
+    const LogRecord rec{LogType::GREEN, 1, __FILE__, __LINE__, "Bench", "Model registered success [Delete order 0]",
+                        std::chrono::system_clock::now()};
+    constexpr size_t iterations = 200000;
+
+    size_t sink         = 0;
+    const double legacy = nsPerOp(iterations, [&] { sink += legacyRender(format, rec).size(); });
+    const LogFormat compiled(format);
+    std::string buf;
+    const double current = nsPerOp(iterations, [&] {
+        buf.clear();
+        compiled.render(buf, rec, false);
+        sink += buf.size();
+    });
+    report.add("log_format/legacy", legacy, "ns/line", iterations);
+    report.add("log_format/compiled", current, "ns/line", iterations);
+    keep(sink);
+}
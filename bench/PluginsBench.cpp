@@ -0,0 +1,71 @@
+/// Запуск Core с N копиями тестового плагина: весь запуск, поиск и загрузка библиотек, удаление.
+/// Каждый замер - отдельный процесс, чтобы библиотеки загружались с нуля
+#include "Bench.hpp"
+#include <Core.hpp>
+#include <Manifest/PluginsManifest.hpp>
+#include <dlfcn.h>
+#include <iostream>
+
+int d3156::Bench::coreChild(const std::vector<std::string> &args, Report &report)
+{
+    if (args.size() < 2) return 1;
+    std::string program = "PluginCore_bench";
+    char *argv[]        = {program.data(), nullptr};
+    std::unique_ptr<PluginCore::Core> core;
+    const double startup = msOf([&] { core = std::make_unique<PluginCore::Core>(1, argv); });
+    const double teardown = msOf([&] { core.reset(); });
+    report.add("core/startup/" + args[1], startup, "ms", 1);
+    report.add("core/teardown/" + args[1], teardown, "ms", 1);
+    return 0;
+}
+
+int d3156::Bench::loadChild(const std::vector<std::string> &args, Report &report)
+{
+    if (args.size() < 3) return 1;
+    PluginCore::ScanResult scan;
+    const double scan_ms = msOf([&] { scan = PluginCore::scanPluginsDir(args[1]); });
+    size_t loaded        = 0;
+    const double load_ms = msOf([&] {
+        for (const auto &entry : scan.plugins) {
+            void *handle = dlopen(entry.path.c_str(), RTLD_NOW | RTLD_LOCAL);
+            if (handle == nullptr) {
+                std::cerr << dlerror() << std::endl;
+                continue;
+            }
+            using Create  = PluginCore::IPlugin *(*)();
+            using Destroy = void (*)(PluginCore::IPlugin *);
+            const auto create  = reinterpret_cast<Create>(dlsym(handle, "create_plugin"));
+            const auto destroy = reinterpret_cast<Destroy>(dlsym(handle, "destroy_plugin"));
+            if (create && destroy) {
+                destroy(create());
+                ++loaded;
+            }
+            dlclose(handle);
+        }
+    });
+    report.add("plugins/scan/" + args[2], scan_ms, "ms", scan.plugins.size());
+    report.add("plugins/dlopen/" + args[2], load_ms, "ms", loaded);
+    return loaded == scan.plugins.size() ? 0 : 1;
+}
+
+void d3156::Bench::runPluginsBenches(Report &report, const Options &options)
+{
+    for (const size_t count : options.plugins) {
+        const std::string dir = makePluginsDir(count);
+        if (dir.empty()) continue;
+        const std::string n        = std::to_string(count);
+        /// Манифест вне каталога: его запись меняет mtime каталога, и манифест бы не совпадал
+        const std::string manifest = dir + ".manifest";
+        for (size_t r = 0; r < options.repeat; ++r) {
+            runChild({"load", dir, n}, {}, report);
+            runChild({"core", n}, {"PLUGINS_DIR=" + dir, "PLUGINS_MANIFEST=", "PLUGINS_HOT_RELOAD=false"}, report);
+            const std::vector<std::string> env = {"PLUGINS_DIR=" + dir, "PLUGINS_MANIFEST=" + manifest,
+                                                  "PLUGINS_HOT_RELOAD=false"};
+            /// Первый запуск с манифестом его создаёт, замеряются последующие
+            if (Report warmup; r == 0) runChild({"core", n}, env, warmup);
+            runChild({"core", n + "_manifest"}, env, report);
+        }
+        removeDir(dir);
+        removeDir(manifest);
+    }
+}
@@ -0,0 +1,44 @@
+/// ModelsStorage: регистрация новой модели (промах), повторная регистрация (попадание), поиск и удаление моделей
+#include "Bench.hpp"
+#include <IModel.hpp>
+#include <memory>
+#include <utility>
+
+namespace
+{
+    using d3156::PluginCore::ModelsStorage;
+
+    constexpr size_t models_count = 256;
+
+    template <size_t I> struct BenchModel final : d3156::PluginCore::IModel {
+        static std::string name() { return "BenchModel" + std::to_string(I) + "_1.0:bench"; }
+        void init() override {}
+    };
+
+    template <size_t... I> void registerAll(ModelsStorage &storage, std::index_sequence<I...>)
+    {
+        (storage.registerModel<BenchModel<I>>(), ...);
+    }
+}
+
+void d3156::Bench::runStorageBenches(Report &report, const Options &)
+{
+    constexpr size_t rounds = 20;
+    for (size_t round = 0; round < rounds; ++round) {
+        auto storage = std::make_unique<ModelsStorage>();
+        const double miss =
+            msOf([&] { registerAll(*storage, std::make_index_sequence<models_count>()); }) * 1e6 / models_count;
+        report.add("storage/registerModel_miss", miss, "ns/op", models_count);
+        const double teardown = msOf([&] { storage.reset(); });
+        report.add("storage/reset/" + std::to_string(models_count), teardown, "ms", 1);
+    }
+
+    ModelsStorage storage;
+    registerAll(storage, std::make_index_sequence<models_count>());
+    constexpr size_t iterations = 100000;
+    report.add("storage/registerModel_hit",
+               nsPerOp(iterations, [&] { keep(storage.registerModel<BenchModel<models_count / 2>>()); }), "ns/op",
+               iterations);
+    report.add("storage/get", nsPerOp(iterations * 10, [&] { keep(storage.get<BenchModel<models_count / 2>>()); }),
+               "ns/op", iterations * 10);
+}
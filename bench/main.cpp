@@ -0,0 +1,230 @@
+/// Набор бенчмарков PluginCore: результаты в JSON для сравнения между выпусками.
+/// PluginCore_bench [--out results.json] [--filter group] [--plugins 10,100,1000] [--repeat 3]
+#include "Bench.hpp"
+#include <Manifest/PluginsManifest.hpp>
+#include <Utils/Json.hpp>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <spawn.h>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace fs = std::filesystem;
+
+namespace d3156::Bench
+{
+    void Report::add(const std::string &name, const double value, const std::string &unit, const size_t iterations)
+    {
+        const auto it = std::find_if(results_.begin(), results_.end(), [&](const Result &r) { return r.name == name; });
+        if (it == results_.end())
+            results_.push_back({name, value, unit, iterations});
+        else if (value < it->value)
+            *it = {name, value, unit, iterations};
+    }
+
+    void Report::parseLines(const std::string &text)
+    {
+        std::istringstream in(text);
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::string name, value, unit, iterations;
+            if (!std::getline(fields, name, '\t') || !std::getline(fields, value, '\t') ||
+                !std::getline(fields, unit, '\t') || !std::getline(fields, iterations))
+                continue;
+            add(name, std::stod(value), unit, std::stoull(iterations));
+        }
+    }
+
+    std::string Report::lines() const
+    {
+        std::ostringstream out;
+        for (const auto &r : results_) out << r.name << '\t' << r.value << '\t' << r.unit << '\t' << r.iterations << '\n';
+        return out.str();
+    }
+
+    std::string Report::json() const
+    {
+        std::string out = "{\"version\":";
+        appendJsonString(out, PLUGIN_CORE_VERSION);
+        out += ",\"timestamp\":" + std::to_string(std::time(nullptr)) + ",\"results\":[";
+        for (size_t i = 0; i < results_.size(); ++i) {
+            const auto &r = results_[i];
+            out += i ? ",\n" : "\n";
+            out += "{\"name\":";
+            appendJsonString(out, r.name);
+            char value[64];
+            std::snprintf(value, sizeof(value), "%.4f", r.value);
+            out += ",\"value\":" + std::string(value) + ",\"unit\":";
+            appendJsonString(out, r.unit);
+            out += ",\"iterations\":" + std::to_string(r.iterations) + "}";
+        }
+        out += "\n]}\n";
+        return out;
+    }
+
+    bool runChild(const std::vector<std::string> &args, const std::vector<std::string> &env, Report &report)
+    {
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) != 0) return false;
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        posix_spawn_file_actions_adddup2(&actions, fds[1], 3);
+
+        std::vector<std::string> argv_storage = {"PluginCore_bench", "--child"};
+        argv_storage.insert(argv_storage.end(), args.begin(), args.end());
+        std::vector<char *> child_argv;
+        for (auto &arg : argv_storage) child_argv.push_back(arg.data());
+        child_argv.push_back(nullptr);
+
+        /// Переменные env заменяют одноимённые из окружения процесса
+        std::vector<std::string> env_storage(env.begin(), env.end());
+        for (char **e = environ; *e; ++e) {
+            const std::string_view var(*e);
+            const auto name = var.substr(0, var.find('=') + 1);
+            if (std::none_of(env.begin(), env.end(), [&](const std::string &v) { return v.starts_with(name); }))
+                env_storage.emplace_back(var);
+        }
+        std::vector<char *> child_env;
+        for (auto &var : env_storage) child_env.push_back(var.data());
+        child_env.push_back(nullptr);
+
+        pid_t pid      = 0;
+        const int rc   = posix_spawn(&pid, "/proc/self/exe", &actions, nullptr, child_argv.data(), child_env.data());
+        posix_spawn_file_actions_destroy(&actions);
+        close(fds[1]);
+        if (rc != 0) {
+            close(fds[0]);
+            std::cerr << "Cannot start child: " << std::strerror(rc) << std::endl;
+            return false;
+        }
+        std::string text;
+        char buf[4096];
+        for (ssize_t n; (n = read(fds[0], buf, sizeof(buf))) > 0;) text.append(buf, static_cast<size_t>(n));
+        close(fds[0]);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::cerr << "Child " << args.front() << " failed with status " << status << std::endl;
+            return false;
+        }
+        report.parseLines(text);
+        return true;
+    }
+
+    std::string makePluginsDir(const size_t count)
+    {
+        std::string dir = (fs::temp_directory_path() / "PluginCore_bench.XXXXXX").string();
+        if (mkdtemp(dir.data()) == nullptr) return {};
+        /// Имя файла плагина зависит от сборки PluginCore (lib<Name>.Debug.so при DEBUG)
+        const std::string suffix = PluginCore::pluginName("libBench0.so") ? ".so" : ".Debug.so";
+        for (size_t i = 0; i < count; ++i)
+            fs::copy_file(BENCH_DUMMY_PLUGIN, fs::path(dir) / ("libBench" + std::to_string(i) + suffix));
+        return dir;
+    }
+
+    void removeDir(const std::string &path)
+    {
+        std::error_code ec;
+        fs::remove_all(path, ec);
+    }
+}
+
+namespace
+{
+    using namespace d3156::Bench;
+
+    int child(const std::vector<std::string> &args)
+    {
+        Report report;
+        int rc = 1;
+        if (args.empty())
+            std::cerr << "Child kind expected" << std::endl;
+        else if (args[0] == "log")
+            rc = logChild(args, report);
+        else if (args[0] == "core")
+            rc = coreChild(args, report);
+        else if (args[0] == "load")
+            rc = loadChild(args, report);
+        const std::string text = report.lines();
+        if (write(3, text.data(), text.size()) != static_cast<ssize_t>(text.size())) return 1;
+        return rc;
+    }
+
+    std::vector<size_t> parseList(const std::string &list)
+    {
+        std::vector<size_t> out;
+        std::istringstream in(list);
+        for (std::string item; std::getline(in, item, ',');)
+            if (!item.empty()) out.push_back(std::stoull(item));
+        return out;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const std::vector<std::string> args(argv + 1, argv + argc);
+    if (!args.empty() && args[0] == "--child") {
+        const int rc = child({args.begin() + 1, args.end()});
+        std::cout.flush();
+        _exit(rc);
+    }
+
+    Options options;
+    std::string out_path;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const bool has_value = i + 1 < args.size();
+        if (args[i] == "--out" && has_value)
+            out_path = args[++i];
+        else if (args[i] == "--filter" && has_value)
+            options.filter = args[++i];
+        else if (args[i] == "--plugins" && has_value)
+            options.plugins = parseList(args[++i]);
+        else if (args[i] == "--repeat" && has_value)
+            options.repeat = std::max<size_t>(1, std::stoull(args[++i]));
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--out results.json] [--filter group] [--plugins 10,100,1000] [--repeat 3]" << std::endl
+                      << "Groups: log_format, storage, args, log, plugins" << std::endl;
+            return args[i] == "--help" || args[i] == "-h" ? 0 : 1;
+        }
+    }
+
+    /// Логи измеряемого кода уходят в /dev/null, чтобы не смешиваться с JSON
+    const int json_fd = dup(STDOUT_FILENO);
+    const int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDOUT_FILENO);
+    close(null_fd);
+
+    Report report;
+    const std::pair<const char *, void (*)(Report &, const Options &)> groups[] = {
+        {"log_format", runLogFormatBenches}, {"storage", runStorageBenches}, {"args", runArgsBenches},
+        {"log", runLogBenches},              {"plugins", runPluginsBenches},
+    };
+    for (const auto &[group, run] : groups) {
+        if (!options.selected(group)) continue;
+        const size_t before = report.results().size();
+        const double ms     = msOf([&] { run(report, options); });
+        std::cerr << group << ": " << report.results().size() - before << " results in " << ms << " ms" << std::endl;
+    }
+
+    const std::string json = report.json();
+    if (!out_path.empty()) {
+        const int fd = open(out_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || write(fd, json.data(), json.size()) != static_cast<ssize_t>(json.size())) {
+            std::cerr << "Cannot write " << out_path << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        close(fd);
+    } else if (write(json_fd, json.data(), json.size()) != static_cast<ssize_t>(json.size()))
+        return 1;
+    return 0;
+}
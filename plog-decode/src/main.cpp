@@ -0,0 +1,231 @@
+/// plog-decode: перевод сегментов OUT=BINARY в текст по шаблону FORMAT
+/// Использование: plog-decode <segment.plog>... (шаблон берётся из FORMAT или из заголовка сегмента)
+#include <Logger/BinaryLog.hpp>
+#include <Logger/Format.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace d3156;
+
+namespace
+{
+    struct Site {
+        LogType type;
+        int line;
+        std::string file;
+        std::string source;
+    };
+
+    class Reader
+    {
+    public:
+        Reader(const char *data, const size_t size) : data_(data), size_(size) {}
+
+        template <class V> bool read(V &value)
+        {
+            if (pos_ + sizeof(V) > size_) return false;
+            std::memcpy(&value, data_ + pos_, sizeof(V));
+            pos_ += sizeof(V);
+            return true;
+        }
+
+        bool readString(std::string &out)
+        {
+            uint32_t len = 0;
+            if (!read(len) || pos_ + len > size_) return false;
+            out.assign(data_ + pos_, len);
+            pos_ += len;
+            return true;
+        }
+
+        bool atEnd() const { return pos_ >= size_; }
+
+    private:
+        const char *data_;
+        size_t size_;
+        size_t pos_ = 0;
+    };
+
+    /// Повторяет вывод аргументов через std::ostream в текстовом режиме
+    bool decodeArgs(Reader &in, std::string &message)
+    {
+        using LoggerManager::ArgType;
+        std::ostringstream oss;
+        uint8_t tag = 0;
+        while (!in.atEnd() && in.read(tag) && tag != 0) {
+            switch (static_cast<ArgType>(tag)) {
+                case ArgType::I64: {
+                    int64_t v;
+                    if (!in.read(v)) return false;
+                    oss << v;
+                    break;
+                }
+                case ArgType::U64: {
+                    uint64_t v;
+                    if (!in.read(v)) return false;
+                    oss << v;
+                    break;
+                }
+                case ArgType::F64: {
+                    double v;
+                    if (!in.read(v)) return false;
+                    oss << v;
+                    break;
+                }
+                case ArgType::BOOL: {
+                    uint8_t v;
+                    if (!in.read(v)) return false;
+                    oss << static_cast<bool>(v);
+                    break;
+                }
+                case ArgType::CHAR: {
+                    char v;
+                    if (!in.read(v)) return false;
+                    oss << v;
+                    break;
+                }
+                case ArgType::STR: {
+                    std::string v;
+                    if (!in.readString(v)) return false;
+                    oss << v;
+                    break;
+                }
+                case ArgType::PTR: {
+                    uintptr_t v;
+                    if (!in.read(v)) return false;
+                    oss << reinterpret_cast<const void *>(v);
+                    break;
+                }
+                default: return false;
+            }
+        }
+        message = oss.str();
+        return true;
+    }
+
+    /// \brief Ближайшая к pos выровненная позиция, похожая на начало целой записи
+    /// \details Запись публикуется сохранением size последним, поэтому прерванная запись (падение процесса между
+    /// reserve и публикацией) оставляет нулевой size, а записи других потоков за ней могут быть целыми
+    size_t resync(const std::string &data, size_t pos, const std::unordered_map<uint32_t, Site> &sites)
+    {
+        for (; pos + 2 * sizeof(uint32_t) <= data.size(); pos += binary_alignment) {
+            uint32_t size = 0, site_id = 0;
+            std::memcpy(&size, data.data() + pos, sizeof(size));
+            std::memcpy(&site_id, data.data() + pos + sizeof(size), sizeof(site_id));
+            if (size < 2 * sizeof(uint32_t) || size % binary_alignment != 0 || pos + size > data.size()) continue;
+            if (site_id == binary_descriptor_site || site_id == binary_inline_site || sites.contains(site_id))
+                return pos;
+        }
+        return std::string::npos;
+    }
+
+    bool decodeSegment(const std::string &path, std::unordered_map<uint32_t, Site> &sites)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "Cannot open " << path << std::endl;
+            return false;
+        }
+        /// Сегмент читается целиком одним вызовом: открытый сегмент имеет полный размер (LOG_SEGMENT_SIZE)
+        std::string data(static_cast<size_t>(file.seekg(0, std::ios::end).tellg()), '\0');
+        file.seekg(0).read(data.data(), static_cast<std::streamsize>(data.size()));
+        Reader header(data.data(), data.size());
+        char magic[4];
+        uint32_t version = 0;
+        std::string segment_format;
+        if (!header.read(magic) || std::memcmp(magic, binary_magic, sizeof(magic)) != 0 || !header.read(version) ||
+            version != binary_version || !header.readString(segment_format)) {
+            std::cerr << "Not a PluginCore binary log segment: " << path << std::endl;
+            return false;
+        }
+        const char *env_format = std::getenv("FORMAT");
+        const LogFormat format(env_format ? env_format : segment_format);
+
+        size_t pos = (sizeof(magic) + 2 * sizeof(uint32_t) + segment_format.size() + binary_alignment - 1) &
+                     ~(binary_alignment - 1);
+        std::string out;
+        size_t torn = 0, skipped = 0;
+        while (pos + 2 * sizeof(uint32_t) <= data.size()) {
+            uint32_t size = 0, site_id = 0;
+            std::memcpy(&size, data.data() + pos, sizeof(size));
+            if (size < 2 * sizeof(uint32_t) || size % binary_alignment != 0 || pos + size > data.size()) {
+                /// Незавершённая запись: продолжаем со следующей целой, нули до конца сегмента - не записанное место
+                const size_t next = resync(data, pos + binary_alignment, sites);
+                if (next == std::string::npos) break;
+                ++torn;
+                skipped += next - pos;
+                pos = next;
+                continue;
+            }
+            Reader in(data.data() + pos + sizeof(size), size - sizeof(size));
+            pos += size;
+            in.read(site_id);
+            if (site_id == binary_descriptor_site) {
+                uint32_t id = 0;
+                int32_t line = 0;
+                uint8_t type = 0;
+                Site site;
+                if (in.read(id) && in.read(line) && in.read(type) && in.readString(site.file) &&
+                    in.readString(site.source)) {
+                    site.type = static_cast<LogType>(type);
+                    site.line = line;
+                    sites[id] = std::move(site);
+                }
+                continue;
+            }
+            uint64_t time_ns = 0;
+            int32_t level    = 0;
+            if (!in.read(time_ns) || !in.read(level)) continue;
+            Site inline_site;
+            const Site *site = &inline_site;
+            if (site_id == binary_inline_site) {
+                uint8_t type = 0;
+                int32_t line = 0;
+                if (!in.read(type) || !in.read(line) || !in.readString(inline_site.file) ||
+                    !in.readString(inline_site.source))
+                    continue;
+                inline_site.type = static_cast<LogType>(type);
+                inline_site.line = line;
+            } else {
+                const auto it = sites.find(site_id);
+                if (it == sites.end()) {
+                    std::cerr << "Unknown call site " << site_id << " in " << path << std::endl;
+                    continue;
+                }
+                site = &it->second;
+            }
+            std::string message;
+            if (!decodeArgs(in, message)) std::cerr << "Corrupted record in " << path << std::endl;
+            const auto time = std::chrono::system_clock::time_point(
+                std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(time_ns)));
+            out.clear();
+            format.render(out, site->type, level, site->file.c_str(), site->line, site->source.c_str(), message, time,
+                          false);
+            out += '\n';
+            std::cout << out;
+        }
+        if (torn)
+            std::cerr << "Skipped " << torn << " incomplete record(s), " << skipped << " bytes in " << path << std::endl;
+        return true;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <segment" << binary_segment_extension << ">..." << std::endl;
+        return 1;
+    }
+    std::vector<std::string> paths(argv + 1, argv + argc);
+    std::sort(paths.begin(), paths.end());
+    std::unordered_map<uint32_t, Site> sites;
+    bool ok = true;
+    for (const auto &path : paths) ok = decodeSegment(path, sites) && ok;
+    return ok ? 0 : 2;
+}
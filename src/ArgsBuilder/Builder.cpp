@@ -1,4 +1,5 @@
 #include "Builder.hpp"
+#include "Config.hpp"
 #include "Logger/Log.hpp"
 #include <iomanip>
 #include <iostream>
@@ -62,42 +63,67 @@ namespace d3156
         exit(0);
     }
 
-    void Builder::process(AbstractOption *param, const char *str)
+    void Builder::process(AbstractOption *param, const char *str, const AbstractOption::SOURCE source)
     {
-        if (!param->parse(str)) error("Cannot parse " + string(str));
+        if (!param->parse(str)) error("Cannot parse " + string(str) + " for " + param->long_name);
+        param->raw    = str;
+        param->source = source;
     }
 
-    Builder &Builder::parse(int argc, char *argv[])
+    Builder &Builder::parse(int argc, char *argv[]) { return parse(argc, argv, false); }
+
+    Builder &Builder::parseKnown(int argc, char *argv[]) { return parse(argc, argv, true); }
+
+    Builder &Builder::parse(int argc, char *argv[], const bool known_only)
     {
         app_path_ = string(argv[0]);
         for (int i = 1; i < argc; i++) {
             string line(argv[i]);
 
-            if (line == "-h" || line == "--help" || line == "?" || line == "-?") help();
+            if (!known_only && (line == "-h" || line == "--help" || line == "?" || line == "-?")) help();
 
-            if (line == "--version" || line == "-v") version();
+            if (!known_only && (line == "--version" || line == "-v")) version();
 
             AbstractOption *param = nullptr;
 
             if (line.substr(0, 2) == "--") {
                 auto str = line.substr(2);
 
-                if (!params_long_.contains(str)) error("Unknown parameter " + line);
-                param = params_long_[str];
+                if (params_long_.contains(str))
+                    param = params_long_[str];
+                else if (!known_only)
+                    error("Unknown parameter " + line);
             } else if (line.substr(0, 1) == "-") {
                 auto str = line.substr(1);
 
-                if (str.length() > 1) error("Invalid syntax in " + line + " short name must be 1 letter length");
+                if (str.length() > 1 && !known_only)
+                    error("Invalid syntax in " + line + " short name must be 1 letter length");
 
-                if (!params_short_.contains(str[0])) error("Unknown parameter " + line);
-                param = params_short_[str[0]];
-            } else
+                if (str.length() == 1 && params_short_.contains(str[0]))
+                    param = params_short_[str[0]];
+                else if (!known_only)
+                    error("Unknown parameter " + line);
+            } else if (!known_only)
                 error("Invalid syntax in " + line + " -- or - expected");
+            else
+                continue;
+            if (param == nullptr) {
+                if (i + 1 < argc && argv[i + 1][0] != '-') ++i;
+                continue;
+            }
             if (param->type == AbstractOption::FLAG)
-                process(param, "");
+                process(param, "", AbstractOption::ARGV);
+            else if (i + 1 < argc)
+                process(param, argv[++i], AbstractOption::ARGV);
             else
-                process(param, argv[++i]);
+                error("Value expected after " + line);
         }
+        /// Не заданные в командной строке значения берутся из окружения, затем из файла
+        if (config_ != nullptr)
+            for (auto i : all_)
+                if (i->source != AbstractOption::ARGV && !i->long_name.empty())
+                    if (const auto value = config_->value(i->long_name))
+                        process(i, value->c_str(), AbstractOption::CONFIG);
         for (auto i : all_)
             if (i->type == AbstractOption::PARAM && !i->isParsed())
                 error("Parameter must be specified -" + string(1, i->short_name) + " or --" + i->long_name);
@@ -132,6 +158,38 @@ namespace d3156
         return *this;
     }
 
+    Builder &Builder::setConfig(const Config *config)
+    {
+        config_ = config;
+        return *this;
+    }
+
+    Builder &Builder::unknownReload(const std::string &long_name)
+    {
+        Y_LOG(0, "onReload for unknown argument --" << long_name << " ignored");
+        return *this;
+    }
+
+    void Builder::dropReloadHandlers(const std::string &owner)
+    {
+        for (auto i : all_) std::erase_if(i->handlers, [&](const auto &handler) { return handler.owner == owner; });
+    }
+
+    void Builder::reload()
+    {
+        if (config_ == nullptr) return;
+        for (auto i : all_) {
+            if (i->handlers.empty() || i->source == AbstractOption::ARGV) continue;
+            const auto value = config_->value(i->long_name);
+            if (!value || (i->source == AbstractOption::CONFIG && *value == i->raw)) continue;
+            G_LOG(0, "Argument --" << i->long_name << " reloaded: " << *value);
+            i->raw    = *value;
+            i->source = AbstractOption::CONFIG;
+            for (const auto &handler : i->handlers)
+                if (!handler.fn(*value)) Y_LOG(0, "Cannot parse " << *value << " for " << i->long_name);
+        }
+    }
+
     Builder &Builder::addParam(AbstractOption *param)
     {
         all_.push_back(param);
@@ -146,7 +204,12 @@ namespace d3156
         value_ = false;
     }
 
-    bool Builder::Flag::parse(const char *) { return parsed_ = value_ = true; }
+    bool Builder::Flag::parse(const char *str)
+    {
+        parsed_ = true;
+        if (*str == '\0') return value_ = true;
+        return from_string(std::string_view(str), value_);
+    }
 
     Builder::AbstractOption::AbstractOption(const TYPE t, const char s, std::string l, std::string d)
         : type(t), short_name(s), long_name(std::move(l)), description(std::move(d))
@@ -1,25 +1,58 @@
 #pragma once
+#include "Logger/Log.hpp"
+#include <charconv>
+#include <functional>
 #include <map>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 namespace d3156
 {
-    template <typename T> bool from_string(const char *str, T &val)
+    /// \brief Разобрать значение аргумента: числа - std::from_chars целиком (префикс 0x - шестнадцатеричное),
+    /// bool - true/false/1/0/yes/no/on/off, строки - как есть, прочие типы - через operator>>
+    template <typename T> bool from_string(std::string_view str, T &val)
     {
-        const std::string data(str);
-        if (data.empty()) return false;
-        std::istringstream iss(data);
-        if (data.find("0x") != std::string::npos)
-            iss >> std::hex >> val;
-        else
-            iss >> std::dec >> val;
-        return !iss.fail();
+        if constexpr (std::is_same_v<T, std::string>) {
+            val = str;
+            return true;
+        } else if (str.empty())
+            return false;
+        else if constexpr (std::is_same_v<T, bool>) {
+            for (const std::string_view yes : {"true", "1", "yes", "on"})
+                if (str == yes) {
+                    val = true;
+                    return true;
+                }
+            for (const std::string_view no : {"false", "0", "no", "off"})
+                if (str == no) {
+                    val = false;
+                    return true;
+                }
+            return false;
+        } else if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, char>) {
+            if (str.front() == '+') str.remove_prefix(1);
+            const char *end = str.data() + str.size();
+            std::from_chars_result result{};
+            if constexpr (std::is_integral_v<T>) {
+                const bool hex = str.starts_with("0x") || str.starts_with("0X");
+                result         = std::from_chars(str.data() + (hex ? 2 : 0), end, val, hex ? 16 : 10);
+            } else
+                result = std::from_chars(str.data(), end, val);
+            return result.ec == std::errc() && result.ptr == end;
+        } else {
+            std::istringstream iss{std::string(str)};
+            iss >> val;
+            return !iss.fail();
+        }
     }
 
     namespace Args
     {
+        class Config;
+
         void printHeader(int argc, char *argv[]);
 
         class Builder
@@ -31,6 +64,14 @@ namespace d3156
 
             public:
                 enum TYPE { OPTION, PARAM, FLAG } type;
+                /// Откуда взято значение: из командной строки оно не перечитывается
+                enum SOURCE { NONE, CONFIG, ARGV } source = NONE;
+                std::string raw; ///< Значение в виде строки, с ним сравнивается перечитанное
+                struct Handler {
+                    std::string owner;
+                    std::function<bool(std::string_view)> fn;
+                };
+                std::vector<Handler> handlers;
 
                 char short_name = 0;
                 std::string long_name;
@@ -59,7 +100,7 @@ namespace d3156
 
                 bool parse(const char *str) override
                 {
-                    const bool ok = from_string(str, value_);
+                    const bool ok = from_string(std::string_view(str), value_);
                     parsed_       = true;
                     return ok;
                 }
@@ -84,6 +125,11 @@ namespace d3156
 
             Builder &parse(int argc, char *argv[]);
 
+            /// \brief Разобрать только зарегистрированные в этом Builder аргументы, остальные пропустить
+            /// \note Значение неизвестного аргумента пропускается, если не начинается с '-'. Используется при
+            /// перезагрузке плагина, когда аргументы других плагинов уже разобраны
+            Builder &parseKnown(int argc, char *argv[]);
+
             template <class Type>
             Builder &addOption(Type &value, char short_name, std::string long_name = "", std::string description = "")
             {
@@ -117,8 +163,40 @@ namespace d3156
 
             Builder &setCompanyText(const std::string &company);
 
+            /// \brief Брать значения, не заданные в командной строке, из файла конфигурации и окружения
+            Builder &setConfig(const Config *config);
+
+            /// \brief Вызвать fn с новым значением аргумента long_name, если оно изменилось при перечитывании
+            /// конфигурации (SIGHUP)
+            /// \note Привязанная к аргументу переменная при перечитывании не меняется, чтобы её можно было читать из
+            /// любых потоков без синхронизации: новое значение получает только fn, в потоке цикла событий.
+            /// Аргумент из командной строки не перечитывается
+            template <class Type>
+            Builder &onReload(const std::string &long_name, std::function<void(const Type &)> fn,
+                              std::string owner = LOG_NAME)
+            {
+                const auto it = params_long_.find(long_name);
+                if (it == params_long_.end()) return unknownReload(long_name);
+                it->second->handlers.push_back({std::move(owner), [fn = std::move(fn)](std::string_view str) {
+                                                    Type value{};
+                                                    if (!from_string(str, value)) return false;
+                                                    fn(value);
+                                                    return true;
+                                                }});
+                return *this;
+            }
+
+            /// \brief Удалить обработчики onReload плагина owner (перед его выгрузкой)
+            void dropReloadHandlers(const std::string &owner);
+
+            /// \brief Перечитать значения из конфигурации и вызвать обработчики изменившихся аргументов
+            void reload();
+
         private:
-            static void process(AbstractOption *param, const char *str);
+            static void process(AbstractOption *param, const char *str, AbstractOption::SOURCE source);
+            Builder &unknownReload(const std::string &long_name);
+
+            Builder &parse(int argc, char *argv[], bool known_only);
 
             void version() const;
 
@@ -132,6 +210,7 @@ namespace d3156
             std::string version_;
             std::string app_path_;
             std::string company_text_;
+            const Config *config_ = nullptr;
         };
     } // namespace Args
 }
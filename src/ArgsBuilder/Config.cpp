@@ -0,0 +1,89 @@
+#include "Config.hpp"
+#include "Logger/Log.hpp"
+#include <cctype>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace d3156::Args
+{
+#undef LOG_NAME
+#define LOG_NAME "Args"
+
+    namespace
+    {
+        std::string_view trim(std::string_view str)
+        {
+            while (!str.empty() && std::isspace(static_cast<unsigned char>(str.front()))) str.remove_prefix(1);
+            while (!str.empty() && std::isspace(static_cast<unsigned char>(str.back()))) str.remove_suffix(1);
+            return str;
+        }
+    }
+
+    std::string Config::pathFromArgs(const int argc, char *argv[])
+    {
+        for (int i = 1; i + 1 < argc; ++i)
+            if (std::strcmp(argv[i], "--config") == 0) return argv[i + 1];
+        if (const char *path = std::getenv("PLUGINS_CONFIG")) return path;
+        return {};
+    }
+
+    std::string Config::envName(const std::string_view long_name)
+    {
+        std::string name = "ARG_";
+        for (const char c : long_name)
+            name += std::isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(std::toupper(c)) : '_';
+        return name;
+    }
+
+    bool Config::load(const std::string &path)
+    {
+        const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st{};
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            R_LOG(0, "Cannot read config " << path << ": " << std::strerror(errno));
+            if (fd >= 0) close(fd);
+            return false;
+        }
+        std::unordered_map<std::string, std::string> values;
+        if (st.st_size > 0) {
+            void *data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                R_LOG(0, "Cannot map config " << path << ": " << std::strerror(errno));
+                close(fd);
+                return false;
+            }
+            std::string_view text(static_cast<const char *>(data), static_cast<size_t>(st.st_size));
+            for (size_t number = 1; !text.empty(); ++number) {
+                const size_t end = std::min(text.find('\n'), text.size());
+                std::string_view line = trim(text.substr(0, end));
+                text.remove_prefix(std::min(end + 1, text.size()));
+                if (line.empty() || line.front() == '#') continue;
+                const size_t eq = line.find('=');
+                if (eq == std::string_view::npos || trim(line.substr(0, eq)).empty()) {
+                    Y_LOG(0, "Config " << path << ":" << number << ": \"name = value\" expected, line skipped");
+                    continue;
+                }
+                std::string_view value = trim(line.substr(eq + 1));
+                if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+                    value = value.substr(1, value.size() - 2);
+                values[std::string(trim(line.substr(0, eq)))] = value;
+            }
+            munmap(data, static_cast<size_t>(st.st_size));
+        }
+        close(fd);
+        path_   = path;
+        values_ = std::move(values);
+        G_LOG(0, "Config " << path << " loaded: " << values_.size() << " values");
+        return true;
+    }
+
+    std::optional<std::string> Config::value(const std::string_view long_name) const
+    {
+        if (const char *env = std::getenv(envName(long_name).c_str())) return env;
+        if (const auto it = values_.find(std::string(long_name)); it != values_.end()) return it->second;
+        return std::nullopt;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace d3156::Args
+{
+    /// \brief Источники значений аргументов помимо командной строки: файл конфигурации и переменные окружения
+    /// \details Файл задаётся аргументом --config <файл> или PLUGINS_CONFIG и читается один раз через mmap. Формат -
+    /// строки "имя = значение" (имя - длинное имя аргумента без "--", '#' - комментарий, значение можно взять в
+    /// кавычки). Переменная окружения ARG_<ИМЯ> (имя в верхнем регистре, символы кроме букв и цифр заменены на '_')
+    /// важнее файла, командная строка - важнее обоих.
+    class Config
+    {
+    public:
+        /// \return Путь из --config или PLUGINS_CONFIG, пустой - файла нет
+        static std::string pathFromArgs(int argc, char *argv[]);
+        /// \brief Имя переменной окружения для аргумента long_name
+        static std::string envName(std::string_view long_name);
+
+        /// \return false, если файл не удалось прочитать
+        bool load(const std::string &path);
+        /// \brief Перечитать файл (SIGHUP)
+        bool reload() { return path_.empty() || load(path_); }
+
+        /// \return Значение аргумента из окружения или файла, nullopt - не задано
+        std::optional<std::string> value(std::string_view long_name) const;
+        const std::string &path() const { return path_; }
+
+    private:
+        std::string path_;
+        std::unordered_map<std::string, std::string> values_;
+    };
+}
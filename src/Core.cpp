@@ -1,7 +1,19 @@
 #include "Core.hpp"
+#include "Manifest/PluginsManifest.hpp"
+#include "Placement/Placement.hpp"
+#include "Utils/ParallelFor.hpp"
+#include "Utils/Watchdog.hpp"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
 #include <dlfcn.h>
+#include <cstring>
 #include <filesystem>
-#include <regex>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
 
 namespace fs = std::filesystem;
 
@@ -10,8 +22,13 @@ namespace d3156::PluginCore
     struct IPluginLoaderLib {
         using Create    = IPlugin *(*)();
         using Destroy   = void (*)(IPlugin *);
+        using FullName  = const char *(*)();
         IPlugin *plugin = nullptr;
         Destroy destroy = nullptr;
+        std::string path;
+        std::string full_name; ///< Из необязательного plugin_full_name(), пустое - плагин его не экспортирует
+        /// \return full_name или имя плагина, если FULL_NAME нет
+        std::string ownerName(const std::string &name) const { return full_name.empty() ? name : full_name; }
         static std::unique_ptr<IPluginLoaderLib> load(const std::string &path);
         ~IPluginLoaderLib();
 
@@ -20,23 +37,102 @@ namespace d3156::PluginCore
         void *h_ = nullptr;
     };
 
-    Core::Core(int argc, char *argv[])
+    Core::Core(int argc, char *argv[]) : argc_(argc), argv_(argv)
     {
-        Args::printHeader(argc, argv);
-        Args::Builder bldr;
-        bldr.setVersion("d3156::PluginCore " + std::string(PLUGIN_CORE_VERSION));
-        loadPlugins();
-        for (auto &lib : libs_) lib.second->plugin->registerArgs(bldr);
-        for (auto &lib : libs_) {
-            models_.current_plugin = lib.first;
-            lib.second->plugin->registerModels(models_);
-        }
-        models_.finishRegistering();
-        for (auto i : models_) i.second->registerArgs(bldr);
-        bldr.parse(argc, argv);
-        for (auto i : models_) i.second->postInit();
-        for (auto &lib : libs_) lib.second->plugin->postInit();
+        auto phase = [this](const char *name, auto &&fn) {
+            Profiler::Scope scope(profiler_, name, "phase");
+            fn();
+        };
+        phase("printHeader", [&] { Args::printHeader(argc, argv); });
+        if (const auto path = Args::Config::pathFromArgs(argc, argv); !path.empty() && !config_.load(path)) exit(-1);
+        builder_            = std::make_unique<Args::Builder>();
+        Args::Builder &bldr = *builder_;
+        bldr.setVersion("d3156::PluginCore " + std::string(PLUGIN_CORE_VERSION))
+            .setConfig(&config_)
+            .addFlag(rescan_, "rescan", "ignore plugins manifest and scan PLUGINS_DIR")
+            .addOption(config_path_, "config", "file with argument values (name = value), reread on SIGHUP");
+        /// Флаг нужен до разбора аргументов: плагины ищутся раньше, чем они регистрируют свои аргументы
+        for (int i = 1; i < argc; ++i)
+            if (std::strcmp(argv[i], "--rescan") == 0) rescan_ = true;
+        models_.profiler_ = &profiler_;
+        phase("loadPlugins", [&] { loadPlugins(); });
+        phase("plugins registerArgs", [&] {
+            for (auto &lib : libs_) {
+                Profiler::Scope scope(profiler_, lib.first + "::registerArgs", "plugin");
+                lib.second->plugin->registerArgs(bldr);
+            }
+        });
+        phase("plugins registerModels", [&] {
+            /// Модели Core регистрируются до моделей плагинов, чтобы плагины получили их экземпляры
+            models_.current_plugin = "Core";
+            /// Memory - первой: ресурсы памяти получают все следующие модели
+            memory_                = models_.registerModel<Memory>();
+            models_.memory_        = memory_;
+            executor_              = models_.registerModel<Executor>();
+            loop_                  = models_.registerModel<EventLoop>();
+            models_.registerModel<Metrics>()->loop_ = loop_;
+            models_.registerModel<Tracer>()->loop_  = loop_;
+            models_.registerModel<EventBus>()->executor_ = executor_;
+            models_.on_register_ = [&](const std::string &model) {
+                const auto it = lazy_models_.find(model.substr(0, model.find_first_of('_')));
+                if (it != lazy_models_.end()) activate(it->second, bldr);
+            };
+            /// Активированные плагины добавляются в libs_ во время обхода, поэтому обходим снимок имён. Порядок - по
+            /// имени: создатель модели, общей для нескольких плагинов (и ключ её PersistentRegion), не зависит от
+            /// порядка хеш-таблицы
+            std::vector<std::string> names;
+            for (const auto &lib : libs_) names.push_back(lib.first);
+            std::sort(names.begin(), names.end());
+            for (const auto &name : names) {
+                Profiler::Scope scope(profiler_, name + "::registerModels", "plugin");
+                Placement::Scope placement(name);
+                models_.current_plugin = name;
+                libs_[name]->plugin->registerModels(models_);
+            }
+            models_.on_register_ = nullptr;
+            for (const auto &[name, path] : lazy_) G_LOG(0, "Plugin " << name << " not requested, left unloaded");
+        });
+        phase("models init", [&] { models_.initDeferred(); });
+        phase("finishRegistering", [&] { models_.finishRegistering(); });
+        phase("models registerArgs", [&] {
+            for (auto i : models_) {
+                Profiler::Scope scope(profiler_, i.first + "::registerArgs", "model");
+                i.second->registerArgs(bldr);
+            }
+        });
+        phase("parse", [&] { bldr.parse(argc, argv); });
+        phase("models postInit", [&] {
+            executor_->start();
+            models_.postInitAll();
+        });
+        phase("plugins postInit", [&] {
+            for (auto &lib : libs_) {
+                Profiler::Scope scope(profiler_, lib.first + "::postInit", "plugin");
+                Placement::Scope placement(lib.first);
+                lib.second->plugin->postInit();
+            }
+        });
+        profiler_.finish();
         if (libs_.empty()) exit(0);
+        reload_subscription_ = models_.get<EventBus>()->subscribe<std::string>(
+            "PluginCore.reload", [this](const std::string &name) { loop_->post([this, name] { reloadPlugin(name); }); },
+            EventBus::Delivery::Inline, 0, "Core");
+        if (const char *val = std::getenv("PLUGINS_HOT_RELOAD"); val && std::strncmp(val, "true", 5) == 0)
+            watchPlugins();
+        loop_->onSignal(SIGHUP, [this] { reloadConfig(); });
+        if (const auto period = Watchdog::timeoutFromEnv("MEMORY_LOG_PERIOD_MS", std::chrono::milliseconds(0));
+            period.count() > 0)
+            loop_->addTimer(period, [this] { G_LOG(0, memory_->report()); }, period);
+    }
+
+    int Core::run() { return loop_->run(); }
+
+    void Core::reloadConfig()
+    {
+        G_LOG(0, "SIGHUP: reloading config " << (config_.path().empty() ? "(environment only)" : config_.path()));
+        if (!config_.reload()) return;
+        builder_->reload();
+        for (auto &[name, bldr] : plugin_builders_) bldr->reload();
     }
 
     const std::string client_plugins_path = "./Plugins";
@@ -68,55 +164,308 @@ namespace d3156::PluginCore
         return out;
     }
 
+    /// \return true, если в командной строке есть аргумент --arg (--arg=...) или -a для однобуквенного имени
+    static bool hasArgument(const int argc, char *argv[], const std::string &arg)
+    {
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view token = argv[i];
+            if (arg.size() == 1 && token.size() == 2 && token[0] == '-' && token[1] == arg[0]) return true;
+            if (!token.starts_with("--")) continue;
+            const std::string_view name = token.substr(2, token.find('=') - 2);
+            if (name == arg) return true;
+        }
+        return false;
+    }
+
     void Core::loadPlugins()
     {
+        using clock      = std::chrono::steady_clock;
+        using ms         = std::chrono::duration<double, std::milli>;
+        const auto start = clock::now();
+
+        const size_t threads             = threadsFromEnv("PLUGINS_LOAD_THREADS");
         std::vector<fs::path> pluginsDir = getPaths();
         if (pluginsDir.empty()) R_LOG(0, "Empty existing path list for loading plugin!");
-#ifdef DEBUG
-        const std::regex re(R"(^lib([^\.]*)\.Debug\.so$)");
-#else
-        const std::regex re(R"(^lib([^\.]*)\.so$)");
-#endif
-        for (const auto &pluginDir : pluginsDir) {
-            G_LOG(0, "Loading plugins from dir " << pluginDir);
-            for (const auto &de :
-                 fs::recursive_directory_iterator(pluginDir, fs::directory_options::skip_permission_denied)) {
-                if (!de.is_regular_file()) continue;
-
-                const std::string file = de.path().filename().string();
-
-                std::smatch m;
-                if (!std::regex_match(file, m, re)) continue;
-
-                const std::string name    = m[1].str();
-                const std::string absName = de.path().string();
-
-                auto lib = IPluginLoaderLib::load(absName);
-
-                if (lib == nullptr) continue;
-                G_LOG(0, "Plugin " << name << " loaded");
-                if (libs_.contains(name)) {
-                    Y_LOG(0, "Plugin with name " << name << " already loaded!");
-                    Y_LOG(0, "Plugin with path " << absName << " will be skiped!");
+
+        const std::string manifest_path = PluginsManifest::pathFromEnv();
+        PluginsManifest manifest;
+        if (!manifest_path.empty() && !rescan_) manifest.load(manifest_path);
+
+        std::vector<std::string> roots(pluginsDir.size());
+        std::vector<std::vector<PluginEntry>> found(pluginsDir.size());
+        std::vector<std::optional<ScanResult>> scanned(pluginsDir.size());
+        parallelFor(pluginsDir.size(), threads, [&](const size_t i) {
+            roots[i] = fs::absolute(pluginsDir[i]).lexically_normal().string();
+            if (auto cached = manifest.lookup(roots[i])) {
+                G_LOG(0, "Plugins of dir " << pluginsDir[i] << " taken from manifest " << manifest_path);
+                found[i] = std::move(*cached);
+                return;
+            }
+            G_LOG(0, "Loading plugins from dir " << pluginsDir[i]);
+            scanned[i] = scanPluginsDir(roots[i]);
+            found[i]   = scanned[i]->plugins;
+        });
+        for (size_t i = 0; i < scanned.size(); ++i)
+            if (scanned[i]) manifest.update(roots[i], std::move(*scanned[i]));
+
+        /// Коллизии имён разрешаются до загрузки: загружается первый каталог в PLUGINS_DIR, одноимённые плагины из
+        /// следующих каталогов остаются запасными на случай, если он не загрузится
+        std::vector<PluginEntry> candidates;
+        std::unordered_map<std::string, std::string> chosen;
+        std::unordered_map<std::string, std::vector<PluginEntry>> fallbacks;
+        for (auto &dir : found)
+            for (auto &candidate : dir) {
+                if (const auto it = chosen.find(candidate.name); it != chosen.end()) {
+                    Y_LOG(0, "Plugin with name " << candidate.name << " already found at " << it->second);
+                    Y_LOG(0, "Plugin with path " << candidate.path << " will be used only if it fails to load");
+                    fallbacks[candidate.name].push_back(std::move(candidate));
                     continue;
                 }
-                libs_[name] = std::move(lib);
+                chosen.emplace(candidate.name, candidate.path);
+                candidates.push_back(std::move(candidate));
             }
+
+        /// Плагины с описанием lib<Name>.plugin откладываются, если их не требуют аргументы командной строки
+        bool load_all = false;
+        for (int i = 1; i < argc_; ++i)
+            for (const char *flag : {"-h", "--help", "?", "-?", "-v", "--version"})
+                if (std::strcmp(argv_[i], flag) == 0) load_all = true;
+        std::erase_if(candidates, [&](const PluginEntry &candidate) {
+            const auto sidecar = readSidecar(candidate.path);
+            if (!sidecar) return false;
+            if (load_all) return false;
+            for (const auto &arg : sidecar->args)
+                if (hasArgument(argc_, argv_, arg) || config_.value(arg)) {
+                    G_LOG(0, "Plugin " << candidate.name << " activated by argument " << arg);
+                    return false;
+                }
+            lazy_.emplace(candidate.name, candidate.path);
+            for (const auto &model : sidecar->models) lazy_models_.emplace(model, candidate.name);
+            return true;
+        });
+
+        std::vector<std::unique_ptr<IPluginLoaderLib>> loaded(candidates.size());
+        std::vector<clock::duration> times(candidates.size());
+        parallelFor(candidates.size(), threads, [&](const size_t i) {
+            Profiler::Scope scope(profiler_, candidates[i].name + "::load", "plugin");
+            const auto lib_start = clock::now();
+            loaded[i]            = IPluginLoaderLib::load(candidates[i].path);
+            times[i]             = clock::now() - lib_start;
+        });
+
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            const auto it = loaded[i] == nullptr ? fallbacks.find(candidates[i].name) : fallbacks.end();
+            if (it != fallbacks.end())
+                for (auto &fallback : it->second) {
+                    Y_LOG(0, "Plugin " << candidates[i].name << " failed to load from " << candidates[i].path
+                                       << ", trying " << fallback.path);
+                    const auto lib_start = clock::now();
+                    loaded[i]            = IPluginLoaderLib::load(fallback.path);
+                    times[i]             = clock::now() - lib_start;
+                    candidates[i]        = std::move(fallback);
+                    if (loaded[i] != nullptr) break;
+                }
+            if (loaded[i] == nullptr) continue;
+            G_LOG(0, "Plugin " << candidates[i].name
+                               << (loaded[i]->full_name.empty() ? "" : " (" + loaded[i]->full_name + ")")
+                               << " loaded in " << ms(times[i]).count() << " ms");
+            manifest.setFullName(candidates[i].path, loaded[i]->full_name);
+            models_.full_names_[candidates[i].name] = loaded[i]->ownerName(candidates[i].name);
+            libs_[candidates[i].name]               = std::move(loaded[i]);
         }
+        if (!manifest_path.empty() && manifest.dirty()) manifest.save(manifest_path);
+        G_LOG(0, "Loaded " << libs_.size() << " plugins in " << ms(clock::now() - start).count() << " ms ("
+                           << threads << " threads), " << lazy_.size() << " deferred");
+        std::vector<std::string> names;
+        for (const auto &lib : libs_) names.push_back(lib.first);
+        for (const auto &lib : lazy_) names.push_back(lib.first);
+        Placement::load(names);
+    }
+
+    void Core::activate(const std::string &name, Args::Builder &bldr)
+    {
+        const auto it = lazy_.find(name);
+        if (it == lazy_.end()) return;
+        const std::string path = it->second;
+        lazy_.erase(it);
+        Profiler::Scope scope(profiler_, name + "::activate", "plugin");
+        auto lib = IPluginLoaderLib::load(path);
+        if (lib == nullptr) return;
+        G_LOG(0, "Plugin " << name << " activated by request of model from " << models_.current_plugin);
+        IPlugin *plugin           = lib->plugin;
+        models_.full_names_[name] = lib->ownerName(name);
+        libs_[name]               = std::move(lib);
+        plugin->registerArgs(bldr);
+        const std::string previous = std::exchange(models_.current_plugin, name);
+        Placement::Scope placement(name);
+        plugin->registerModels(models_);
+        models_.current_plugin = previous;
     }
 
     Core::~Core()
     {
         G_LOG(0, "Destroy CORE");
-        for (auto &[fst, snd] : libs_) {
+        reload_subscription_.unsubscribe();
+        /// Обработчики onReload созданы кодом плагинов
+        plugin_builders_.clear();
+        builder_.reset();
+        if (inotify_fd_ >= 0) {
+            loop_->removeFd(inotify_fd_);
+            close(inotify_fd_);
+        }
+        /// Задачи плагинов в общем пуле могут ссылаться на объекты плагинов: пул перестаёт принимать задачи и
+        /// дожидается поставленных до удаления плагинов
+        executor_->stop();
+        {
             /// Сначала удаляем плагины, чтобы они на обратились к несущетсвующей модели
-            G_LOG(0, "Destroy plugin " << fst);
-            if (snd->plugin && snd->destroy) snd->destroy(snd->plugin);
-            snd->plugin = nullptr;
+            std::vector<std::pair<const std::string, std::unique_ptr<IPluginLoaderLib>> *> libs;
+            for (auto &lib : libs_) libs.push_back(&lib);
+            Watchdog watchdog(Watchdog::timeoutFromEnv("PLUGINS_DESTROY_TIMEOUT_MS", std::chrono::milliseconds(0)));
+            parallelFor(libs.size(), threadsFromEnv("PLUGINS_DESTROY_THREADS"), [&](const size_t i) {
+                auto &[fst, snd] = *libs[i];
+                G_LOG(0, "Destroy plugin " << fst);
+                Watchdog::Guard guard(watchdog, "destroy_plugin of " + fst);
+                if (snd->plugin && snd->destroy) snd->destroy(snd->plugin);
+                snd->plugin = nullptr;
+            });
         }
+        if (memory_) G_LOG(0, memory_->report());
         models_.reset(); /// Затем удаляются модели
-        libs_.clear();   /// И только потом выгружаем символы.
+        libs_.clear();     /// И только потом выгружаем символы.
+        retired_libs_.clear();
         G_LOG(0, "CORE destroyed");
+        LoggerManager::flush();
+    }
+
+    void Core::watchPlugins()
+    {
+        inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd_ < 0) {
+            R_LOG(0, "Hot reload disabled: inotify_init1 failed: " << std::strerror(errno));
+            return;
+        }
+        std::unordered_map<int, fs::path> dirs;
+        std::set<fs::path> watched;
+        for (const auto &[name, lib] : libs_) {
+            const fs::path dir = fs::path(lib->path).parent_path();
+            if (!watched.insert(dir).second) continue;
+            const int wd = inotify_add_watch(inotify_fd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (wd < 0)
+                Y_LOG(0, "Hot reload: cannot watch " << dir << ": " << std::strerror(errno));
+            else
+                G_LOG(0, "Hot reload: watching " << dir);
+        }
+        loop_->addFd(inotify_fd_, EPOLLIN, [this](uint32_t) {
+            alignas(inotify_event) char buffer[4096];
+            ssize_t size;
+            while ((size = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+                for (char *p = buffer; p < buffer + size;) {
+                    const auto *event = reinterpret_cast<const inotify_event *>(p);
+                    p += sizeof(inotify_event) + event->len;
+                    if (event->len == 0) continue;
+                    const std::string file = event->name;
+                    for (const auto &[name, lib] : libs_) {
+                        if (fs::path(lib->path).filename() != file) continue;
+                        /// Повторные события в окне ожидания откладывают перезагрузку
+                        if (const auto it = pending_reloads_.find(name); it != pending_reloads_.end())
+                            loop_->cancelTimer(it->second);
+                        pending_reloads_[name] = loop_->addTimer(std::chrono::milliseconds(300), [this, name] {
+                            pending_reloads_.erase(name);
+                            reloadPlugin(name);
+                        });
+                        break;
+                    }
+                }
+            }
+        });
+    }
+
+    bool Core::reloadPlugin(const std::string &name)
+    {
+        using clock      = std::chrono::steady_clock;
+        using ms         = std::chrono::duration<double, std::milli>;
+        const auto start = clock::now();
+        const auto it    = libs_.find(name);
+        if (it == libs_.end()) {
+            Y_LOG(0, "Reload of unknown plugin " << name << " ignored");
+            return false;
+        }
+        const std::string path = it->second->path;
+        G_LOG(0, "Reloading plugin " << name << " from " << path);
+
+        /// dlopen вернёт уже загруженную библиотеку по тому же пути, поэтому загружается копия файла
+        std::error_code ec;
+        const fs::path copy = fs::temp_directory_path(ec) / ("lib" + name + ".reload." + std::to_string(getpid()) + "." +
+                                                             std::to_string(reloads_++) + ".so");
+        if (ec || !fs::copy_file(path, copy, fs::copy_options::overwrite_existing, ec)) {
+            R_LOG(0, "Reload of " << name << " failed: cannot copy " << path << ": " << ec.message());
+            return false;
+        }
+        auto lib = IPluginLoaderLib::load(copy.string());
+        fs::remove(copy, ec);
+        if (!lib) {
+            R_LOG(0, "Reload of " << name << " failed: new library not loaded, old version keeps running");
+            return false;
+        }
+        lib->path = path;
+
+        std::set<std::string> existing;
+        for (const auto &[model, instance] : models_) existing.insert(model);
+        const std::string probe    = name + "@reload";
+        models_.current_plugin     = probe;
+        models_.full_names_[probe] = lib->ownerName(name);
+        {
+            Placement::Scope placement(name);
+            lib->plugin->registerModels(models_);
+        }
+        models_.current_plugin.clear();
+        std::vector<std::string> added;
+        for (const auto &[model, instance] : models_)
+            if (!existing.contains(model)) added.push_back(model);
+
+        if (const auto conflicts = models_.versionConflicts(name); !conflicts.empty()) {
+            for (const auto &model : conflicts)
+                R_LOG(0, "Reload of " << name << " refused: model '" << model << "' would be used in several versions");
+            lib->destroy(lib->plugin);
+            lib->plugin = nullptr;
+            for (const auto &model : added) models_.removeModel(model);
+            models_.replacePlugin(probe, "");
+            models_.full_names_.erase(probe);
+            return false;
+        }
+
+        /// Старая версия: задачи общего пула, затем удаление плагина
+        executor_->quiesce(name);
+        it->second->destroy(it->second->plugin);
+        it->second->plugin = nullptr;
+        retired_libs_.push_back(std::exchange(it->second, std::move(lib)));
+        models_.replacePlugin(probe, name);
+        models_.full_names_[name] = models_.full_names_[probe];
+        models_.full_names_.erase(probe);
+
+        IPlugin *plugin = it->second->plugin;
+        models_.initDeferred();
+        /// Обработчики onReload старой версии ссылаются на её объекты
+        builder_->dropReloadHandlers(name);
+        auto bldr = std::make_unique<Args::Builder>();
+        bldr->setConfig(&config_);
+        plugin->registerArgs(*bldr);
+        ModelsStorage::Level fresh;
+        for (const auto &model : added) {
+            IModel *instance = models_.at(models_.indices_.at(model));
+            instance->registerArgs(*bldr);
+            fresh.emplace_back(model, instance);
+        }
+        bldr->parseKnown(argc_, argv_);
+        plugin_builders_[name] = std::move(bldr);
+        models_.runLevels(models_.dependencyLevels(fresh), "postInit", &IModel::postInit);
+        {
+            Placement::Scope placement(name);
+            plugin->postInit();
+        }
+        G_LOG(0, "Plugin " << name << " reloaded in " << ms(clock::now() - start).count() << " ms (" << added.size()
+                           << " new models)");
+        return true;
     }
 
     template <class Fn> Fn sym(void *h_, const char *name)
@@ -132,6 +481,8 @@ namespace d3156::PluginCore
 
     IPluginLoaderLib::~IPluginLoaderLib()
     {
+        /// Записи асинхронного логгера ссылаются на строки из библиотеки плагина
+        LoggerManager::flush();
         if (h_) dlclose(h_);
     }
 
@@ -154,6 +505,11 @@ namespace d3156::PluginCore
             dlclose(h_);
             return nullptr;
         }
-        return std::unique_ptr<IPluginLoaderLib>(new IPluginLoaderLib(h_, destroy, plugin));
+        auto lib  = std::unique_ptr<IPluginLoaderLib>(new IPluginLoaderLib(h_, destroy, plugin));
+        lib->path = path;
+        /// Необязательный символ: плагины, собранные до его появления, загружаются без него
+        if (const auto full_name = reinterpret_cast<FullName>(dlsym(h_, "plugin_full_name")))
+            lib->full_name = full_name();
+        return lib;
     }
 }
@@ -1,5 +1,13 @@
 #pragma once
+#include "ArgsBuilder/Config.hpp"
+#include "EventBus/EventBus.hpp"
+#include "EventLoop/EventLoop.hpp"
+#include "Executor/Executor.hpp"
 #include "IPlugin.hpp"
+#include "Memory/Memory.hpp"
+#include "Metrics/Metrics.hpp"
+#include "Profiler/Profiler.hpp"
+#include "Tracing/Tracer.hpp"
 #include <memory>
 #include <unordered_map>
 
@@ -12,10 +20,56 @@ namespace d3156::PluginCore
         Core(int argc, char *argv[]);
         ~Core();
 
+        /// \brief Выполнять цикл событий Core в вызывающем (главном) потоке до SIGINT/SIGTERM или EventLoop::stop()
+        /// \return Код завершения для main()
+        int run();
+
+        /// \brief Заменить библиотеку плагина новой версией с диска без перезапуска процесса
+        /// \details Новая библиотека загружается рядом со старой и регистрирует модели в общем хранилище. Если после
+        /// замены модели окажутся в нескольких версиях (проверка finishRegistering), новая версия выгружается, а
+        /// старая продолжает работу. Иначе старый плагин останавливается (задачи общего пула дожидаются) и удаляется,
+        /// его библиотека остаётся загруженной до удаления моделей. Новый плагин получает registerArgs, postInit
+        /// своих новых моделей и postInit.
+        /// \note Вызывается в потоке цикла событий. Запросить перезагрузку из плагина можно публикацией имени
+        /// плагина (std::string) в топик EventBus "PluginCore.reload"
+        /// \return false, если перезагрузка отклонена или не удалась
+        bool reloadPlugin(const std::string &name);
+
     private:
         void loadPlugins();
+        /// \brief Перечитать файл конфигурации и сообщить изменившиеся значения подписчикам onReload (SIGHUP)
+        void reloadConfig();
+        /// \brief Загрузить отложенный плагин: сразу выполняются его registerArgs и registerModels
+        void activate(const std::string &name, Args::Builder &bldr);
+        /// \brief Следить за каталогами плагинов через inotify и перезагружать изменённые (PLUGINS_HOT_RELOAD=true)
+        void watchPlugins();
 
+        Profiler profiler_;
         ModelsStorage models_;
+        Executor *executor_ = nullptr;
+        EventLoop *loop_    = nullptr;
+        Memory *memory_     = nullptr;
+        EventBus::Subscription reload_subscription_;
         std::unordered_map<std::string, std::unique_ptr<IPluginLoaderLib>> libs_;
+        /// Библиотеки заменённых версий плагинов: в них код моделей, созданных старой версией, поэтому они
+        /// выгружаются только после удаления моделей
+        std::vector<std::unique_ptr<IPluginLoaderLib>> retired_libs_;
+        int argc_;
+        char **argv_;
+        int inotify_fd_ = -1;
+        /// Отложенные перезагрузки: запись библиотеки порождает несколько событий inotify
+        std::unordered_map<std::string, EventLoop::TimerId> pending_reloads_;
+        size_t reloads_ = 0;
+        /// Отложенные плагины (с файлом lib<Name>.plugin): имя -> путь к библиотеке, модель без версии -> плагин
+        std::unordered_map<std::string, std::string> lazy_;
+        std::unordered_map<std::string, std::string> lazy_models_;
+        /// --rescan: искать плагины обходом каталогов, не доверяя манифесту
+        bool rescan_ = false;
+        /// Аргументы остаются зарегистрированными для перечитывания конфигурации; аргументы перезагруженных
+        /// плагинов - в отдельных Builder
+        Args::Config config_;
+        std::string config_path_;
+        std::unique_ptr<Args::Builder> builder_;
+        std::unordered_map<std::string, std::unique_ptr<Args::Builder>> plugin_builders_;
     };
 } // namespace d3156::PluginCore
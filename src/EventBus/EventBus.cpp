@@ -0,0 +1,292 @@
+#include "EventBus.hpp"
+#include "Executor/Executor.hpp"
+#include "Placement/Placement.hpp"
+#include "Utils/MpmcQueue.hpp"
+#include <pthread.h>
+#include <thread>
+
+namespace d3156::PluginCore
+{
+    struct EventBus::Subscriber {
+        TopicImpl *topic = nullptr;
+        std::string owner;
+        Delivery delivery = Delivery::Inline;
+        std::function<void(const Event &)> handler;
+        std::unique_ptr<MpmcQueue<Event>> queue;
+        /// Событий, поставленных в очередь и ещё не обработанных: переход 0 -> 1 запускает обработку
+        std::atomic<size_t> queued{0};
+        std::atomic<size_t> busy{0};
+        std::atomic<bool> closed{false};
+        std::thread thread;
+
+        std::atomic<uint64_t> delivered{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<size_t> max_depth{0};
+    };
+
+    struct EventBus::TopicImpl {
+        std::string name;
+        std::string type;
+        /// Подписчики заменяются копией списка: публикация берёт снимок и не держит блокировку при доставке
+        std::mutex mutex;
+        std::shared_ptr<const std::vector<std::shared_ptr<Subscriber>>> subscribers =
+            std::make_shared<const std::vector<std::shared_ptr<Subscriber>>>();
+
+        std::atomic<uint64_t> published{0};
+        std::atomic<uint64_t> delivered{0};
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    namespace
+    {
+        /// Подписчик, обработчик которого выполняется в текущем потоке
+        thread_local const void *current_subscriber = nullptr;
+        /// Событий, обрабатываемых одной задачей пула, прежде чем уступить его другим задачам
+        constexpr size_t executor_batch = 64;
+
+        const char *deliveryName(const EventBus::Delivery delivery)
+        {
+            switch (delivery) {
+                case EventBus::Delivery::Inline: return "inline";
+                case EventBus::Delivery::Executor: return "executor";
+                case EventBus::Delivery::Thread: return "thread";
+            }
+            return "";
+        }
+    }
+
+    std::string EventBus::name() { return "EventBus_" PLUGIN_CORE_VERSION ":PluginCore"; }
+
+    EventBus::EventBus() = default;
+
+    EventBus::~EventBus()
+    {
+        for (const auto &topic : stats()) {
+            if (topic.published == 0) continue;
+            G_LOG(0, "EventBus [" << topic.topic << "] published " << topic.published << ", delivered "
+                                  << topic.delivered << ", dropped " << topic.dropped);
+        }
+        std::unique_lock lock(topics_mutex_);
+        for (auto &[name, topic] : topics_)
+            for (const auto &subscriber : *topic->subscribers) {
+                subscriber->closed = true;
+                if (subscriber->thread.joinable()) {
+                    subscriber->queued++;
+                    subscriber->queued.notify_one();
+                    subscriber->thread.join();
+                }
+            }
+    }
+
+    EventBus::Subscription &EventBus::Subscription::operator=(Subscription &&other) noexcept
+    {
+        if (this == &other) return *this;
+        unsubscribe();
+        bus_        = std::exchange(other.bus_, nullptr);
+        subscriber_ = std::move(other.subscriber_);
+        return *this;
+    }
+
+    void EventBus::Subscription::unsubscribe()
+    {
+        if (!subscriber_) return;
+        bus_->remove(subscriber_);
+        subscriber_.reset();
+        bus_ = nullptr;
+    }
+
+    EventBus::TopicImpl *EventBus::find(const std::string_view name, const char *type)
+    {
+        TopicImpl *topic = nullptr;
+        {
+            std::shared_lock lock(topics_mutex_);
+            if (const auto it = topics_.find(name); it != topics_.end()) topic = it->second.get();
+        }
+        if (topic == nullptr) {
+            std::unique_lock lock(topics_mutex_);
+            auto &created = topics_[std::string(name)];
+            if (!created) {
+                created       = std::make_unique<TopicImpl>();
+                created->name = name;
+                created->type = type;
+            }
+            topic = created.get();
+        }
+        if (topic->type != type) {
+            R_LOG(0, "EventBus topic " << name << " has type " << topic->type << ", requested as " << type);
+            return nullptr;
+        }
+        return topic;
+    }
+
+    EventBus::Subscription EventBus::add(TopicImpl &topic, std::function<void(const Event &)> handler,
+                                         Delivery delivery, const size_t queue_size, const std::string_view owner)
+    {
+        if (delivery == Delivery::Executor && executor_ == nullptr) {
+            Y_LOG(0, "EventBus has no executor, subscriber " << owner << " of " << topic.name << " gets a thread");
+            delivery = Delivery::Thread;
+        }
+        auto subscriber      = std::make_shared<Subscriber>();
+        subscriber->topic    = &topic;
+        subscriber->owner    = owner;
+        subscriber->delivery = delivery;
+        subscriber->handler  = std::move(handler);
+        if (delivery != Delivery::Inline) subscriber->queue = std::make_unique<MpmcQueue<Event>>(queue_size);
+        if (delivery == Delivery::Thread) {
+            /// Поток держит подписчика: при снятии подписки из собственного обработчика поток отсоединяется.
+            /// Размещение потока - по плагину-подписчику, а не по потоку, из которого подписались
+            subscriber->thread = Placement::thread(
+                [this, sub = subscriber] {
+                    Event event;
+                    for (;;) {
+                        const size_t count = sub->queued.load();
+                        if (count == 0) {
+                            sub->queued.wait(0);
+                            continue;
+                        }
+                        if (sub->closed) break;
+                        size_t done = 0;
+                        while (done < count && sub->queue->tryPop(event)) {
+                            deliver(*sub, event);
+                            event.reset();
+                            ++done;
+                        }
+                        sub->queued -= done;
+                    }
+                },
+                subscriber->owner);
+            const std::string thread_name = ("bus-" + subscriber->owner).substr(0, 15);
+            pthread_setname_np(subscriber->thread.native_handle(), thread_name.c_str());
+        }
+        {
+            std::lock_guard lock(topic.mutex);
+            auto subscribers = std::make_shared<std::vector<std::shared_ptr<Subscriber>>>(*topic.subscribers);
+            subscribers->push_back(subscriber);
+            topic.subscribers = std::move(subscribers);
+        }
+        G_LOG(0, "EventBus: " << owner << " subscribed to " << topic.name << " (" << deliveryName(delivery) << ")");
+        return {this, std::move(subscriber)};
+    }
+
+    void EventBus::remove(const std::shared_ptr<Subscriber> &subscriber)
+    {
+        TopicImpl &topic = *subscriber->topic;
+        {
+            std::lock_guard lock(topic.mutex);
+            auto subscribers = std::make_shared<std::vector<std::shared_ptr<Subscriber>>>();
+            for (const auto &other : *topic.subscribers)
+                if (other != subscriber) subscribers->push_back(other);
+            topic.subscribers = std::move(subscribers);
+        }
+        subscriber->closed = true;
+        if (subscriber->thread.joinable()) {
+            subscriber->queued++;
+            subscriber->queued.notify_one();
+            if (subscriber->thread.get_id() == std::this_thread::get_id())
+                subscriber->thread.detach();
+            else
+                subscriber->thread.join();
+        }
+        /// Дожидаемся обработчика, выполняющегося в другом потоке
+        if (current_subscriber != subscriber.get())
+            while (subscriber->busy.load() != 0) std::this_thread::yield();
+    }
+
+    size_t EventBus::publish(TopicImpl &topic, Event event)
+    {
+        std::shared_ptr<const std::vector<std::shared_ptr<Subscriber>>> subscribers;
+        {
+            std::lock_guard lock(topic.mutex);
+            subscribers = topic.subscribers;
+        }
+        topic.published++;
+        size_t accepted = 0;
+        for (const auto &subscriber : *subscribers) {
+            if (subscriber->delivery == Delivery::Inline) {
+                deliver(*subscriber, event);
+                ++accepted;
+                continue;
+            }
+            if (!subscriber->queue->tryPush(event)) {
+                subscriber->dropped++;
+                topic.dropped++;
+                continue;
+            }
+            ++accepted;
+            const size_t depth = subscriber->queued.fetch_add(1) + 1;
+            if (depth > subscriber->max_depth.load(std::memory_order_relaxed))
+                subscriber->max_depth.store(depth, std::memory_order_relaxed);
+            if (depth != 1) continue;
+            if (subscriber->delivery == Delivery::Thread)
+                subscriber->queued.notify_one();
+            else if (!schedule(subscriber))
+                drain(subscriber);
+        }
+        return accepted;
+    }
+
+    bool EventBus::schedule(const std::shared_ptr<Subscriber> &subscriber)
+    {
+        return executor_->post([this, subscriber] { drain(subscriber); }, Executor::Priority::Normal,
+                               subscriber->owner);
+    }
+
+    void EventBus::deliver(Subscriber &subscriber, const Event &event)
+    {
+        subscriber.busy++;
+        if (!subscriber.closed) {
+            const void *previous = std::exchange(current_subscriber, &subscriber);
+            try {
+                subscriber.handler(event);
+            } catch (const std::exception &e) {
+                R_LOG(0, "EventBus handler of " << subscriber.owner << " for " << subscriber.topic->name
+                                                << " threw: " << e.what());
+            } catch (...) {
+                R_LOG(0, "EventBus handler of " << subscriber.owner << " for " << subscriber.topic->name
+                                                << " threw unknown exception");
+            }
+            current_subscriber = previous;
+            subscriber.delivered++;
+            subscriber.topic->delivered++;
+        }
+        subscriber.busy--;
+    }
+
+    void EventBus::drain(const std::shared_ptr<Subscriber> &subscriber)
+    {
+        for (;;) {
+            const size_t count = std::min(subscriber->queued.load(), executor_batch);
+            size_t done        = 0;
+            Event event;
+            while (done < count && subscriber->queue->tryPop(event)) {
+                deliver(*subscriber, event);
+                event.reset();
+                ++done;
+            }
+            /// Остались события - продолжаем отдельной задачей, чтобы не занимать поток пула надолго
+            if (subscriber->queued.fetch_sub(done) == done || schedule(subscriber)) return;
+        }
+    }
+
+    std::vector<EventBus::TopicStats> EventBus::stats() const
+    {
+        std::shared_lock lock(topics_mutex_);
+        std::vector<TopicStats> out;
+        out.reserve(topics_.size());
+        for (const auto &[name, topic] : topics_) {
+            TopicStats stat{name, topic->type, topic->published.load(), topic->delivered.load(),
+                            topic->dropped.load(), {}};
+            std::shared_ptr<const std::vector<std::shared_ptr<Subscriber>>> subscribers;
+            {
+                std::lock_guard topic_lock(topic->mutex);
+                subscribers = topic->subscribers;
+            }
+            for (const auto &subscriber : *subscribers)
+                stat.subscribers.push_back({subscriber->owner, subscriber->delivery, subscriber->queued.load(),
+                                            subscriber->max_depth.load(), subscriber->delivered.load(),
+                                            subscriber->dropped.load()});
+            out.push_back(std::move(stat));
+        }
+        return out;
+    }
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include "IModel.hpp"
+#include <functional>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <typeinfo>
+
+namespace d3156::PluginCore
+{
+    class Executor;
+
+    /// \brief Шина событий между плагинами с типизированными топиками
+    /// \details Событие - неизменяемый объект под std::shared_ptr<const T>: все подписчики получают один и тот же
+    /// объект без копирования. У подписчика с доставкой Executor или Thread своя ограниченная lock-free очередь,
+    /// при её переполнении событие для этого подписчика отбрасывается и учитывается в счётчиках.
+    /// Подписываться следует в registerModels(), объект Subscription хранить в плагине: при его удалении подписка
+    /// снимается. После остановки пула Core (при завершении) события подписчиков Executor доставляются в потоке
+    /// публикации.
+    class EventBus final : public IModel
+    {
+    public:
+        using Event = std::shared_ptr<const void>;
+
+        enum class Delivery {
+            Inline,   ///< Обработчик вызывается в потоке публикации
+            Executor, ///< Обработчик вызывается задачей общего пула Core (события подписчика - последовательно)
+            Thread    ///< Обработчик вызывается в отдельном потоке подписчика
+        };
+
+        struct SubscriberStats {
+            std::string owner;
+            Delivery delivery;
+            size_t depth       = 0; ///< Событий в очереди
+            size_t max_depth   = 0; ///< Наибольшая наблюдавшаяся глубина очереди
+            uint64_t delivered = 0;
+            uint64_t dropped   = 0;
+        };
+
+        struct TopicStats {
+            std::string topic;
+            std::string type;
+            uint64_t published = 0;
+            uint64_t delivered = 0;
+            uint64_t dropped   = 0;
+            std::vector<SubscriberStats> subscribers;
+        };
+
+    private:
+        struct TopicImpl;
+        struct Subscriber;
+
+    public:
+        /// \brief Подписка на топик. Снимается при удалении объекта или вызове unsubscribe()
+        /// \note Снятие подписки дожидается завершения выполняющегося обработчика (кроме вызова из него самого)
+        class Subscription
+        {
+        public:
+            Subscription() = default;
+            Subscription(Subscription &&other) noexcept { *this = std::move(other); }
+            Subscription &operator=(Subscription &&other) noexcept;
+            ~Subscription() { unsubscribe(); }
+
+            void unsubscribe();
+            explicit operator bool() const { return subscriber_ != nullptr; }
+
+        private:
+            friend class EventBus;
+            Subscription(EventBus *bus, std::shared_ptr<Subscriber> subscriber)
+                : bus_(bus), subscriber_(std::move(subscriber))
+            {
+            }
+
+            EventBus *bus_ = nullptr;
+            std::shared_ptr<Subscriber> subscriber_;
+        };
+
+        /// \brief Типизированный топик: публикация без поиска топика по имени
+        template <class T> class Topic
+        {
+        public:
+            Topic() = default;
+
+            /// \return Число подписчиков, принявших событие
+            size_t publish(std::shared_ptr<const T> event) const
+            {
+                return topic_ ? bus_->publish(*topic_, std::move(event)) : 0;
+            }
+
+            template <class... Args> size_t emplace(Args &&...args) const
+            {
+                return publish(std::make_shared<const T>(std::forward<Args>(args)...));
+            }
+
+            explicit operator bool() const { return topic_ != nullptr; }
+
+        private:
+            friend class EventBus;
+            Topic(EventBus *bus, TopicImpl *topic) : bus_(bus), topic_(topic) {}
+
+            EventBus *bus_    = nullptr;
+            TopicImpl *topic_ = nullptr;
+        };
+
+        static std::string name();
+        int deleteOrder() override { return 999; }
+        void init() override {}
+        EventBus();
+        ~EventBus() override;
+
+        /// \brief Получить топик. Топик создаётся при первом обращении и связывается с типом T
+        /// \note При обращении к топику с другим типом в лог выводится ошибка и возвращается пустой топик
+        template <class T> Topic<T> topic(const std::string_view name) { return {this, find(name, typeid(T).name())}; }
+
+        /// \brief Опубликовать событие в топик name
+        template <class T> size_t publish(const std::string_view name, std::shared_ptr<const T> event)
+        {
+            return topic<T>(name).publish(std::move(event));
+        }
+
+        /// \brief Подписаться на топик
+        /// \param handler Вызывается с const T & или const std::shared_ptr<const T> &
+        /// \param queue_size Ёмкость очереди подписчика (для Executor и Thread)
+        /// \param owner Владелец подписки для счётчиков, по умолчанию - LOG_NAME вызывающего плагина
+        template <class T, class Handler>
+        Subscription subscribe(const std::string_view name, Handler &&handler,
+                               const Delivery delivery = Delivery::Inline, const size_t queue_size = 1024,
+                               const std::string_view owner = LOG_NAME)
+        {
+            TopicImpl *topic = find(name, typeid(T).name());
+            if (topic == nullptr) return {};
+            auto fn = [handler = std::forward<Handler>(handler)](const Event &event) mutable {
+                if constexpr (std::is_invocable_v<decltype(handler) &, const std::shared_ptr<const T> &>)
+                    handler(std::static_pointer_cast<const T>(event));
+                else
+                    handler(*static_cast<const T *>(event.get()));
+            };
+            return add(*topic, std::move(fn), delivery, queue_size, owner);
+        }
+
+        std::vector<TopicStats> stats() const;
+
+    private:
+        friend class Core;
+
+        TopicImpl *find(std::string_view name, const char *type);
+        Subscription add(TopicImpl &topic, std::function<void(const Event &)> handler, Delivery delivery,
+                         size_t queue_size, std::string_view owner);
+        void remove(const std::shared_ptr<Subscriber> &subscriber);
+        size_t publish(TopicImpl &topic, Event event);
+        void deliver(Subscriber &subscriber, const Event &event);
+        /// \brief Поставить обработку очереди подписчика Executor задачей пула
+        /// \return false, если пул задачу не принял (останавливается): очередь обрабатывает вызывающий поток
+        bool schedule(const std::shared_ptr<Subscriber> &subscriber);
+        void drain(const std::shared_ptr<Subscriber> &subscriber);
+
+        Executor *executor_ = nullptr;
+        mutable std::shared_mutex topics_mutex_;
+        std::map<std::string, std::unique_ptr<TopicImpl>, std::less<>> topics_;
+    };
+}
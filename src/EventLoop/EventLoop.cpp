@@ -0,0 +1,336 @@
+#include "EventLoop.hpp"
+#include <csignal>
+#include <cstring>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+namespace d3156::PluginCore
+{
+    namespace
+    {
+        sigset_t loopSignals()
+        {
+            sigset_t set;
+            sigemptyset(&set);
+            sigaddset(&set, SIGINT);
+            sigaddset(&set, SIGTERM);
+            sigaddset(&set, SIGHUP);
+            return set;
+        }
+    }
+
+    std::string EventLoop::name() { return "EventLoop_" PLUGIN_CORE_VERSION ":PluginCore"; }
+
+    EventLoop::EventLoop() = default;
+
+    void EventLoop::blockSignals()
+    {
+        const sigset_t set = loopSignals();
+        pthread_sigmask(SIG_BLOCK, &set, nullptr);
+    }
+
+    void EventLoop::init()
+    {
+        start_    = std::chrono::steady_clock::now();
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd_  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        const sigset_t set = loopSignals();
+        signal_fd_         = signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (epoll_fd_ < 0 || wake_fd_ < 0 || signal_fd_ < 0) {
+            R_LOG(0, "EventLoop: cannot create epoll/eventfd/signalfd: " << std::strerror(errno));
+            exit(-1);
+        }
+        for (const int fd : {wake_fd_, signal_fd_}) {
+            epoll_event ev{};
+            ev.events  = EPOLLIN;
+            ev.data.fd = fd;
+            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+        }
+    }
+
+    EventLoop::~EventLoop()
+    {
+        for (const int fd : {signal_fd_, wake_fd_, epoll_fd_})
+            if (fd >= 0) close(fd);
+    }
+
+    uint64_t EventLoop::ticksNow() const
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+    void EventLoop::wake()
+    {
+        const uint64_t one = 1;
+        if (write(wake_fd_, &one, sizeof(one)) < 0 && errno != EAGAIN)
+            R_LOG(0, "EventLoop: eventfd write failed: " << std::strerror(errno));
+    }
+
+    void EventLoop::post(std::function<void()> fn)
+    {
+        {
+            std::lock_guard lock(mutex_);
+            posted_.push_back(std::move(fn));
+        }
+        wake();
+    }
+
+    void EventLoop::stop()
+    {
+        post([this] { shutdown(); });
+    }
+
+    void EventLoop::shutdown()
+    {
+        if (shutdown_) return;
+        shutdown_ = true;
+        std::vector<Callback> handlers;
+        {
+            std::lock_guard lock(mutex_);
+            handlers = shutdown_handlers_;
+        }
+        G_LOG(0, "EventLoop: shutting down, " << handlers.size() << " shutdown handlers");
+        for (const auto &handler : handlers) (*handler)();
+        stop_ = true;
+    }
+
+    void EventLoop::onShutdown(std::function<void()> fn)
+    {
+        std::lock_guard lock(mutex_);
+        shutdown_handlers_.push_back(std::make_shared<std::function<void()>>(std::move(fn)));
+    }
+
+    void EventLoop::onSignal(const int signo, std::function<void()> fn)
+    {
+        const sigset_t set = loopSignals();
+        if (!sigismember(&set, signo)) {
+            R_LOG(0, "EventLoop: signal " << signo << " is not handled by the loop");
+            return;
+        }
+        std::lock_guard lock(mutex_);
+        signal_handlers_[signo].push_back(std::make_shared<std::function<void()>>(std::move(fn)));
+    }
+
+    void EventLoop::handleSignals()
+    {
+        signalfd_siginfo info{};
+        while (read(signal_fd_, &info, sizeof(info)) == sizeof(info)) {
+            const int signo = static_cast<int>(info.ssi_signo);
+            G_LOG(0, "EventLoop: received signal " << strsignal(signo));
+            std::vector<Callback> handlers;
+            {
+                std::lock_guard lock(mutex_);
+                if (const auto it = signal_handlers_.find(signo); it != signal_handlers_.end()) handlers = it->second;
+            }
+            for (const auto &handler : handlers) (*handler)();
+            if (signo == SIGINT || signo == SIGTERM) shutdown();
+        }
+    }
+
+    bool EventLoop::addFd(const int fd, const uint32_t events, std::function<void(uint32_t)> fn)
+    {
+        std::lock_guard lock(mutex_);
+        epoll_event ev{};
+        ev.events  = events;
+        ev.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            R_LOG(0, "EventLoop: cannot watch fd " << fd << ": " << std::strerror(errno));
+            return false;
+        }
+        fds_[fd] = std::make_shared<std::function<void(uint32_t)>>(std::move(fn));
+        return true;
+    }
+
+    bool EventLoop::removeFd(const int fd)
+    {
+        std::lock_guard lock(mutex_);
+        if (fds_.erase(fd) == 0) return false;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        return true;
+    }
+
+    EventLoop::TimerId EventLoop::addTimer(const std::chrono::milliseconds delay, std::function<void()> fn,
+                                           const std::chrono::milliseconds period)
+    {
+        TimerId id;
+        {
+            std::lock_guard lock(mutex_);
+            id = next_timer_id_++;
+            const uint64_t expiry = ticksNow() + std::max<int64_t>(delay.count(), 0);
+            timers_.emplace(id, Timer{expiry, static_cast<uint64_t>(std::max<int64_t>(period.count(), 0)),
+                                      std::make_shared<std::function<void()>>(std::move(fn))});
+            insert(id, expiry);
+        }
+        /// Цикл пересчитает таймаут ожидания с учётом нового таймера
+        if (!inLoop()) wake();
+        return id;
+    }
+
+    bool EventLoop::cancelTimer(const TimerId id)
+    {
+        std::lock_guard lock(mutex_);
+        return timers_.erase(id) != 0;
+    }
+
+    void EventLoop::insert(const TimerId id, uint64_t expiry)
+    {
+        if (expiry <= tick_) expiry = tick_ + 1;
+        const uint64_t delta = expiry - tick_;
+        size_t level         = 0;
+        while (level + 1 < wheel_levels && delta >= uint64_t(1) << (wheel_bits * (level + 1))) ++level;
+        size_t slot = (expiry >> (wheel_bits * level)) & (wheel_size - 1);
+        /// Срок дальше диапазона колеса: таймер ждёт в последней ячейке старшего уровня и будет размещён повторно
+        if (delta >= uint64_t(1) << (wheel_bits * wheel_levels))
+            slot = ((tick_ >> (wheel_bits * level)) + wheel_size - 1) & (wheel_size - 1);
+        wheel_[level][slot].push_back(id);
+        level_entries_[level]++;
+    }
+
+    void EventLoop::expire(const uint64_t tick, std::vector<TimerId> &due)
+    {
+        /// Сначала старшие уровни переносят таймеры, срок которых подошёл, на младшие
+        for (size_t level = wheel_levels - 1; level > 0; --level) {
+            if (tick & ((uint64_t(1) << (wheel_bits * level)) - 1)) continue;
+            auto &cell = wheel_[level][(tick >> (wheel_bits * level)) & (wheel_size - 1)];
+            if (cell.empty()) continue;
+            std::vector<TimerId> ids;
+            ids.swap(cell);
+            level_entries_[level] -= ids.size();
+            for (const TimerId id : ids)
+                if (const auto it = timers_.find(id); it != timers_.end()) insert(id, it->second.expiry);
+        }
+        auto &cell = wheel_[0][tick & (wheel_size - 1)];
+        if (cell.empty()) return;
+        std::vector<TimerId> ids;
+        ids.swap(cell);
+        level_entries_[0] -= ids.size();
+        for (const TimerId id : ids) {
+            const auto it = timers_.find(id);
+            if (it == timers_.end()) continue;
+            Timer &timer = it->second;
+            if (timer.expiry > tick) {
+                insert(id, timer.expiry);
+                continue;
+            }
+            due.push_back(id);
+            if (timer.period == 0) continue;
+            timer.expiry += timer.period;
+            /// Пропущенные из-за долгих обработчиков периоды не наверстываются
+            if (timer.expiry <= tick) timer.expiry = tick + timer.period;
+            insert(id, timer.expiry);
+        }
+    }
+
+    void EventLoop::advance(const uint64_t target, std::vector<TimerId> &due)
+    {
+        while (tick_ < target) {
+            /// Пока младшие уровни пусты, шаги до ближайшей границы следующего уровня пропускаются
+            size_t level = 0;
+            while (level < wheel_levels && level_entries_[level] == 0) ++level;
+            if (level == wheel_levels) {
+                tick_ = target;
+                return;
+            }
+            const uint64_t span = uint64_t(1) << (wheel_bits * level);
+            const uint64_t next = (tick_ / span + 1) * span;
+            if (next > target) {
+                tick_ = target;
+                return;
+            }
+            tick_ = next;
+            expire(tick_, due);
+        }
+    }
+
+    int EventLoop::timeout() const
+    {
+        /// Ближайшее событие колеса: непустая ячейка уровня 0 или граница, на которой старший уровень переносит
+        /// таймеры вниз. Учитываются все непустые уровни: таймер уровня 1 может сработать раньше таймеров уровня 0
+        uint64_t next = UINT64_MAX;
+        for (size_t level = 0; level < wheel_levels; ++level) {
+            if (level_entries_[level] == 0) continue;
+            if (level == 0) {
+                uint64_t slot = tick_ + 1;
+                while (wheel_[0][slot & (wheel_size - 1)].empty()) ++slot;
+                next = slot;
+                continue;
+            }
+            const uint64_t span = uint64_t(1) << (wheel_bits * level);
+            next                = std::min(next, (tick_ / span + 1) * span);
+        }
+        if (next == UINT64_MAX) return -1;
+        const uint64_t now = ticksNow();
+        return next > now ? static_cast<int>(std::min<uint64_t>(next - now, INT32_MAX)) : 0;
+    }
+
+    void EventLoop::runTimers(const std::vector<TimerId> &due)
+    {
+        for (const TimerId id : due) {
+            Callback fn;
+            {
+                std::lock_guard lock(mutex_);
+                const auto it = timers_.find(id);
+                if (it == timers_.end()) continue;
+                fn = it->second.fn;
+                if (it->second.period == 0) timers_.erase(it);
+            }
+            (*fn)();
+        }
+    }
+
+    int EventLoop::run()
+    {
+        blockSignals();
+        loop_thread_ = std::this_thread::get_id();
+        G_LOG(0, "EventLoop: running on the main thread");
+        std::array<epoll_event, 64> events{};
+        std::vector<TimerId> due;
+        std::vector<std::function<void()>> posted;
+        while (!stop_) {
+            int wait;
+            {
+                std::lock_guard lock(mutex_);
+                wait = posted_.empty() ? timeout() : 0;
+            }
+            const int count = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), wait);
+            if (count < 0 && errno != EINTR) {
+                R_LOG(0, "EventLoop: epoll_wait failed: " << std::strerror(errno));
+                break;
+            }
+            for (int i = 0; i < count; ++i) {
+                const int fd = events[i].data.fd;
+                if (fd == wake_fd_) {
+                    uint64_t value;
+                    while (read(wake_fd_, &value, sizeof(value)) == sizeof(value)) {}
+                } else if (fd == signal_fd_)
+                    handleSignals();
+                else {
+                    std::shared_ptr<std::function<void(uint32_t)>> handler;
+                    {
+                        std::lock_guard lock(mutex_);
+                        if (const auto it = fds_.find(fd); it != fds_.end()) handler = it->second;
+                    }
+                    if (handler) (*handler)(events[i].events);
+                }
+            }
+            {
+                std::lock_guard lock(mutex_);
+                posted.swap(posted_);
+                advance(ticksNow(), due);
+            }
+            for (auto &fn : posted) fn();
+            posted.clear();
+            runTimers(due);
+            due.clear();
+        }
+        loop_thread_ = std::thread::id();
+        /// Повторный сигнал во время удаления Core завершит процесс действием по умолчанию
+        const sigset_t set = loopSignals();
+        pthread_sigmask(SIG_UNBLOCK, &set, nullptr);
+        G_LOG(0, "EventLoop: stopped");
+        return 0;
+    }
+}
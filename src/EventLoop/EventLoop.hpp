@@ -0,0 +1,108 @@
+#pragma once
+#include "IModel.hpp"
+#include <array>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace d3156::PluginCore
+{
+    /// \brief Цикл событий главного потока, которым владеет Core
+    /// \details epoll с signalfd (SIGINT, SIGTERM, SIGHUP), eventfd для пробуждения и иерархическим колесом таймеров
+    /// с шагом 1 мс. Плагины регистрируют дескрипторы, таймеры и обработчики сигналов - все обратные вызовы
+    /// выполняются в потоке цикла (главном потоке, вызвавшем Core::run()).
+    /// SIGINT/SIGTERM и stop() запускают завершение: вызываются обработчики onShutdown(), после чего run() возвращает
+    /// управление и приложение удаляет Core.
+    class EventLoop final : public IModel
+    {
+    public:
+        using TimerId = uint64_t;
+
+        static std::string name();
+        int deleteOrder() override { return 998; }
+        void init() override;
+        EventLoop();
+        ~EventLoop() override;
+
+        /// \brief Заблокировать SIGINT, SIGTERM и SIGHUP в вызывающем потоке
+        /// \note Вызывается в main() до создания Core: потоки наследуют маску, и сигналы получает только signalfd цикла
+        static void blockSignals();
+
+        /// \brief Выполнять цикл в вызывающем потоке до завершения
+        /// \return 0 - завершение по сигналу или stop()
+        int run();
+        /// \brief Запустить завершение: обработчики onShutdown() и выход из run(). Можно вызывать из любого потока
+        void stop();
+        /// \return true, если вызывающий поток - поток цикла
+        bool inLoop() const { return std::this_thread::get_id() == loop_thread_.load(); }
+
+        /// \brief Выполнить fn в потоке цикла
+        void post(std::function<void()> fn);
+
+        /// \brief Таймер: первый вызов через delay, далее - с периодом period (0 - однократный)
+        /// \return Идентификатор для cancelTimer
+        TimerId addTimer(std::chrono::milliseconds delay, std::function<void()> fn,
+                         std::chrono::milliseconds period = std::chrono::milliseconds(0));
+        /// \brief Отменить таймер. В потоке цикла гарантирует, что таймер больше не будет вызван
+        bool cancelTimer(TimerId id);
+
+        /// \brief Следить за дескриптором: fn(events) вызывается при готовности (EPOLLIN, EPOLLOUT, ...)
+        bool addFd(int fd, uint32_t events, std::function<void(uint32_t)> fn);
+        bool removeFd(int fd);
+
+        /// \brief Обработчик сигнала SIGINT, SIGTERM или SIGHUP
+        /// \note После обработчиков SIGINT и SIGTERM цикл завершается
+        void onSignal(int signo, std::function<void()> fn);
+        /// \brief Обработчик завершения: вызывается в потоке цикла до выхода из run()
+        void onShutdown(std::function<void()> fn);
+
+    private:
+        using Callback = std::shared_ptr<std::function<void()>>;
+
+        struct Timer {
+            uint64_t expiry;
+            uint64_t period;
+            Callback fn;
+        };
+
+        static constexpr unsigned wheel_bits = 6;
+        static constexpr size_t wheel_size   = size_t(1) << wheel_bits;
+        static constexpr size_t wheel_levels = 4;
+
+        uint64_t ticksNow() const;
+        /// \brief Поместить таймер в колесо: уровень выбирается по удалённости срока от текущего шага
+        void insert(TimerId id, uint64_t expiry);
+        /// \brief Продвинуть колесо до шага target, собрав сработавшие таймеры
+        void advance(uint64_t target, std::vector<TimerId> &due);
+        void expire(uint64_t tick, std::vector<TimerId> &due);
+        void runTimers(const std::vector<TimerId> &due);
+        /// \return Таймаут epoll_wait в миллисекундах, -1 - таймеров нет
+        int timeout() const;
+        void wake();
+        void handleSignals();
+        void shutdown();
+
+        int epoll_fd_  = -1;
+        int wake_fd_   = -1;
+        int signal_fd_ = -1;
+        std::atomic<std::thread::id> loop_thread_;
+        std::atomic<bool> stop_{false};
+        bool shutdown_ = false;
+        std::chrono::steady_clock::time_point start_;
+
+        mutable std::mutex mutex_;
+        std::vector<std::function<void()>> posted_;
+        std::unordered_map<int, std::shared_ptr<std::function<void(uint32_t)>>> fds_;
+        std::unordered_map<int, std::vector<Callback>> signal_handlers_;
+        std::vector<Callback> shutdown_handlers_;
+
+        /// Колесо таймеров: в ячейках - идентификаторы, отменённые таймеры удаляются из ячеек при их обработке
+        std::array<std::array<std::vector<TimerId>, wheel_size>, wheel_levels> wheel_;
+        std::array<size_t, wheel_levels> level_entries_{};
+        std::unordered_map<TimerId, Timer> timers_;
+        uint64_t tick_         = 0;
+        TimerId next_timer_id_ = 1;
+    };
+}
@@ -0,0 +1,270 @@
+#include "Executor.hpp"
+#include "Placement/Placement.hpp"
+#include "Tracing/Tracer.hpp"
+#include "Utils/ParallelFor.hpp"
+#include "Utils/Watchdog.hpp"
+#include <pthread.h>
+
+namespace d3156::PluginCore
+{
+    namespace
+    {
+        /// Пул и индекс рабочего потока, которому принадлежит текущий поток
+        thread_local const Executor *current_executor = nullptr;
+        thread_local size_t current_worker            = 0;
+    }
+
+    std::string Executor::name() { return "Executor_" PLUGIN_CORE_VERSION ":PluginCore"; }
+
+    void Executor::init()
+    {
+        const size_t threads = threadsFromEnv("EXECUTOR_THREADS", availableCpus());
+        workers_.clear();
+        for (size_t i = 0; i < threads; ++i) workers_.push_back(std::make_unique<Worker>());
+        G_LOG(0, "Executor: " << threads << " worker threads (" << availableCpus() << " CPUs available)");
+    }
+
+    Executor::~Executor() { stop(); }
+
+    bool Executor::inWorker() const { return current_executor == this; }
+
+    Executor::Account *Executor::account(const std::string_view owner)
+    {
+        {
+            std::shared_lock lock(accounts_mutex_);
+            if (const auto it = accounts_.find(owner); it != accounts_.end()) return it->second.get();
+        }
+        std::unique_lock lock(accounts_mutex_);
+        auto &account = accounts_[std::string(owner)];
+        if (!account) {
+            account        = std::make_unique<Account>();
+            account->owner = owner;
+        }
+        return account.get();
+    }
+
+    bool Executor::enqueue(std::function<void()> fn, const Priority priority, const std::string_view owner)
+    {
+        const auto prio = static_cast<size_t>(priority);
+        /// Задача выполняется в контексте span, из которого поставлена
+        if (const auto context = Tracer::current())
+            fn = [context, fn = std::move(fn)] {
+                Tracer::Adopt adopt(context);
+                fn();
+            };
+        Task task{std::move(fn), account(owner)};
+        unfinished_++;
+        if (state_.load() == State::Created) {
+            std::lock_guard lock(backlog_mutex_);
+            if (state_.load() == State::Created) {
+                task.account->queued++;
+                backlog_.emplace_back(std::move(task), prio);
+                return true;
+            }
+        }
+        if (const State state = state_.load(); state == State::Draining || state == State::Stopped) {
+            if (--unfinished_ == 0) {
+                std::lock_guard lock(sleep_mutex_);
+                idle_.notify_all();
+            }
+            Y_LOG(0, "Executor is " << (state == State::Draining ? "stopping" : "stopped") << ", task of " << owner
+                                    << " rejected");
+            return false;
+        }
+        task.account->queued++;
+        push(std::move(task), prio);
+        return true;
+    }
+
+    void Executor::push(Task task, const size_t priority)
+    {
+        if (current_executor == this) {
+            auto &worker = *workers_[current_worker];
+            std::lock_guard lock(worker.mutex);
+            worker.queues[priority].push_back(std::move(task));
+        } else {
+            std::lock_guard lock(inject_mutex_);
+            inject_[priority].push_back(std::move(task));
+            injected_++;
+        }
+        pending_++;
+        if (sleeping_.load() > 0) {
+            std::lock_guard lock(sleep_mutex_);
+        }
+        wake_.notify_one();
+    }
+
+    bool Executor::pop(const size_t self, Task &out)
+    {
+        for (size_t prio = 0; prio < priorities; ++prio) {
+            {
+                auto &own = *workers_[self];
+                std::lock_guard lock(own.mutex);
+                if (auto &queue = own.queues[prio]; !queue.empty()) {
+                    out = std::move(queue.back());
+                    queue.pop_back();
+                    pending_--;
+                    return true;
+                }
+            }
+            if (injected_.load() > 0) {
+                std::lock_guard lock(inject_mutex_);
+                if (auto &queue = inject_[prio]; !queue.empty()) {
+                    out = std::move(queue.front());
+                    queue.pop_front();
+                    injected_--;
+                    pending_--;
+                    return true;
+                }
+            }
+            for (size_t i = 1; i < workers_.size(); ++i) {
+                auto &victim = *workers_[(self + i) % workers_.size()];
+                std::lock_guard lock(victim.mutex);
+                if (auto &queue = victim.queues[prio]; !queue.empty()) {
+                    out = std::move(queue.front());
+                    queue.pop_front();
+                    pending_--;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void Executor::execute(Task &task)
+    {
+        Account &account = *task.account;
+        account.queued--;
+        account.running++;
+        const auto start = std::chrono::steady_clock::now();
+        try {
+            task.fn();
+        } catch (const std::exception &e) {
+            account.failed++;
+            R_LOG(0, "Executor task of " << account.owner << " threw: " << e.what());
+        } catch (...) {
+            account.failed++;
+            R_LOG(0, "Executor task of " << account.owner << " threw unknown exception");
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        account.busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        account.executed++;
+        task.fn = nullptr;
+        account.running--;
+        if (--unfinished_ == 0) {
+            std::lock_guard lock(sleep_mutex_);
+            idle_.notify_all();
+        }
+    }
+
+    void Executor::run(const size_t self)
+    {
+        current_executor = this;
+        current_worker   = self;
+        for (;;) {
+            Task task;
+            if (pop(self, task)) {
+                execute(task);
+                continue;
+            }
+            std::unique_lock lock(sleep_mutex_);
+            sleeping_++;
+            wake_.wait(lock, [&] { return pending_.load() > 0 || state_.load() == State::Stopped; });
+            sleeping_--;
+            if (state_.load() == State::Stopped && pending_.load() == 0) break;
+        }
+        current_executor = nullptr;
+    }
+
+    void Executor::start()
+    {
+        std::lock_guard lock(backlog_mutex_);
+        if (state_.load() != State::Created) return;
+        if (workers_.empty()) init();
+        for (auto &[task, prio] : backlog_) {
+            inject_[prio].push_back(std::move(task));
+            injected_++;
+            pending_++;
+        }
+        if (!backlog_.empty()) G_LOG(0, "Executor: " << backlog_.size() << " tasks queued before start");
+        backlog_.clear();
+        state_ = State::Running;
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            threads_.emplace_back([this, i] {
+                Placement::apply("Executor");
+                run(i);
+            });
+            const std::string thread_name = "executor-" + std::to_string(i);
+            pthread_setname_np(threads_.back().native_handle(), thread_name.c_str());
+        }
+    }
+
+    void Executor::stop()
+    {
+        if (inWorker()) {
+            R_LOG(0, "Executor cannot be stopped from its own worker thread");
+            return;
+        }
+        {
+            std::lock_guard lock(backlog_mutex_);
+            if (state_.load() == State::Created) {
+                if (!backlog_.empty()) Y_LOG(0, "Executor was not started, " << backlog_.size() << " tasks dropped");
+                for (auto &[task, prio] : backlog_) task.account->queued--;
+                unfinished_ -= backlog_.size();
+                backlog_.clear();
+                state_ = State::Stopped;
+                return;
+            }
+        }
+        State running = State::Running;
+        /// Новые задачи (в т.ч. поставленные самими задачами) отклоняются до ожидания: иначе задачи, которые
+        /// переставляют себя, не дали бы очереди опустеть
+        if (!state_.compare_exchange_strong(running, State::Draining)) return;
+        {
+            Watchdog watchdog(Watchdog::timeoutFromEnv("EXECUTOR_DRAIN_TIMEOUT_MS", std::chrono::milliseconds(5000)));
+            Watchdog::Guard guard(watchdog, "Executor drain");
+            std::unique_lock lock(sleep_mutex_);
+            idle_.wait(lock, [&] { return unfinished_.load() == 0; });
+            state_ = State::Stopped;
+        }
+        wake_.notify_all();
+        for (auto &thread : threads_) thread.join();
+        threads_.clear();
+        /// Задачи, поставленные в гонке с остановкой, выполняются на вызывающем потоке
+        while (unfinished_.load() > 0) {
+            Task task;
+            if (pop(0, task))
+                execute(task);
+            else
+                std::this_thread::yield();
+        }
+        for (const auto &stat : stats())
+            G_LOG(0, "Executor [" << stat.owner << "] executed " << stat.executed << " tasks (" << stat.failed
+                                  << " failed), busy " << stat.busy_ms << " ms");
+    }
+
+    void Executor::quiesce(const std::string_view owner)
+    {
+        Account *account = nullptr;
+        {
+            std::shared_lock lock(accounts_mutex_);
+            if (const auto it = accounts_.find(owner); it != accounts_.end()) account = it->second.get();
+        }
+        if (account == nullptr || inWorker() || state_.load() != State::Running) return;
+        Watchdog watchdog(Watchdog::timeoutFromEnv("EXECUTOR_DRAIN_TIMEOUT_MS", std::chrono::milliseconds(5000)));
+        Watchdog::Guard guard(watchdog, "Executor quiesce of " + account->owner);
+        while (account->queued.load() != 0 || account->running.load() != 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::vector<Executor::OwnerStats> Executor::stats() const
+    {
+        std::shared_lock lock(accounts_mutex_);
+        std::vector<OwnerStats> out;
+        out.reserve(accounts_.size());
+        for (const auto &[owner, account] : accounts_)
+            out.push_back({owner, account->queued.load(), account->executed.load(), account->failed.load(),
+                           static_cast<double>(account->busy_ns.load()) / 1e6});
+        return out;
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include "IModel.hpp"
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <shared_mutex>
+#include <string_view>
+#include <thread>
+
+namespace d3156::PluginCore
+{
+    /// \brief Общий пул потоков с перехватом задач (work stealing), которым владеет Core
+    /// \details Плагины получают его через models.registerModel<Executor>() вместо запуска собственных потоков.
+    /// Число потоков - по маске CPU affinity процесса (EXECUTOR_THREADS=N переопределяет, 0 - по маске).
+    /// Core запускает пул перед postInit моделей и при завершении, до удаления плагинов, перестаёт принимать задачи и
+    /// дожидается выполнения поставленных. Задачи, поставленные до запуска, выполнятся после него.
+    class Executor final : public IModel
+    {
+    public:
+        enum class Priority { High, Normal, Low };
+
+        /// \brief Учёт задач одного владельца (плагина)
+        struct OwnerStats {
+            std::string owner;
+            size_t queued     = 0; ///< Ожидают выполнения
+            uint64_t executed = 0; ///< Выполнено (в т.ч. с исключением)
+            uint64_t failed   = 0; ///< Завершились исключением
+            double busy_ms    = 0; ///< Суммарное время выполнения
+        };
+
+        static std::string name();
+        int deleteOrder() override { return 1000; }
+        void init() override;
+        ~Executor() override;
+
+        /// \brief Поставить задачу в очередь
+        /// \param owner Владелец для учёта задач, по умолчанию - LOG_NAME вызывающего плагина
+        /// \return false, если пул останавливается или остановлен
+        bool post(std::function<void()> fn, Priority priority = Priority::Normal, std::string_view owner = LOG_NAME)
+        {
+            return enqueue(std::move(fn), priority, owner);
+        }
+
+        /// \brief Поставить задачу в очередь и получить future её результата
+        /// \note Если пул останавливается или остановлен, future вернёт std::future_error (broken_promise)
+        template <class Fn>
+        auto submit(Fn &&fn, Priority priority = Priority::Normal, std::string_view owner = LOG_NAME)
+            -> std::future<std::invoke_result_t<Fn>>
+        {
+            using Result = std::invoke_result_t<Fn>;
+            auto task    = std::make_shared<std::packaged_task<Result()>>(std::forward<Fn>(fn));
+            auto future  = task->get_future();
+            enqueue([task] { (*task)(); }, priority, owner);
+            return future;
+        }
+
+        /// \brief Число рабочих потоков
+        size_t threads() const { return workers_.size(); }
+
+        /// \return true, если вызывающий поток - рабочий поток пула
+        bool inWorker() const;
+
+        std::vector<OwnerStats> stats() const;
+
+    private:
+        friend class Core;
+
+        struct Account {
+            std::string owner;
+            std::atomic<size_t> queued{0};
+            std::atomic<size_t> running{0};
+            std::atomic<uint64_t> executed{0};
+            std::atomic<uint64_t> failed{0};
+            std::atomic<uint64_t> busy_ns{0};
+        };
+
+        struct Task {
+            std::function<void()> fn;
+            Account *account = nullptr;
+        };
+
+        static constexpr size_t priorities = 3;
+
+        /// Очереди рабочего потока по приоритетам с задачами, поставленными самим потоком: владелец берёт задачи с
+        /// конца, остальные перехватывают с начала
+        struct Worker {
+            std::mutex mutex;
+            std::array<std::deque<Task>, priorities> queues;
+        };
+
+        /// Draining - задачи больше не принимаются, поставленные выполняются
+        enum class State { Created, Running, Draining, Stopped };
+
+        bool enqueue(std::function<void()> fn, Priority priority, std::string_view owner);
+        Account *account(std::string_view owner);
+        void push(Task task, size_t priority);
+        bool pop(size_t self, Task &out);
+        void run(size_t self);
+        void execute(Task &task);
+
+        /// \brief Запустить рабочие потоки (вызывается Core перед postInit моделей)
+        void start();
+        /// \brief Перестать принимать задачи, дождаться выполнения поставленных и остановить потоки
+        /// (вызывается Core перед удалением плагинов)
+        void stop();
+        /// \brief Дождаться выполнения поставленных задач владельца (перед выгрузкой плагина)
+        void quiesce(std::string_view owner);
+
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::vector<std::thread> threads_;
+        std::atomic<State> state_{State::Created};
+
+        /// Задачи, поставленные извне пула: общая очередь по приоритетам, из которой потоки берут задачи с начала,
+        /// чтобы под постоянной внешней нагрузкой ранние задачи не ждали бесконечно
+        std::mutex inject_mutex_;
+        std::array<std::deque<Task>, priorities> inject_;
+        std::atomic<size_t> injected_{0};
+
+        /// Задачи, поставленные в очередь до запуска пула
+        std::mutex backlog_mutex_;
+        std::vector<std::pair<Task, size_t>> backlog_;
+
+        /// Число задач в очередях (для пробуждения потоков) и ещё не завершённых задач (для остановки)
+        std::atomic<size_t> pending_{0};
+        std::atomic<size_t> unfinished_{0};
+        std::atomic<size_t> sleeping_{0};
+        std::mutex sleep_mutex_;
+        std::condition_variable wake_;
+        std::condition_variable idle_;
+
+        mutable std::shared_mutex accounts_mutex_;
+        std::map<std::string, std::unique_ptr<Account>, std::less<>> accounts_;
+    };
+}
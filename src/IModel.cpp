@@ -1,23 +1,247 @@
 #include "IModel.hpp"
+#include "Memory/Memory.hpp"
+#include "Placement/Placement.hpp"
+#include "Profiler/Profiler.hpp"
+#include "Utils/ParallelFor.hpp"
+#include "Utils/Watchdog.hpp"
+#include <algorithm>
 #include <iostream>
+#include <map>
 
 namespace d3156::PluginCore
 {
+    static std::atomic<uint64_t> next_generation{1};
+
+    ModelsStorage::ModelsStorage()
+        : init_threads_(threadsFromEnv("MODELS_INIT_THREADS")), generation_(next_generation++)
+    {
+    }
+
+    void ModelsStorage::addModel(const std::string &name, IModel *model)
+    {
+        insert({name, model});
+        const size_t index = next_index_++;
+        auto &slot         = chunks_.at(index / chunk_size);
+        auto *chunk        = slot.load(std::memory_order_relaxed);
+        if (!chunk) {
+            chunk = new std::atomic<IModel *>[chunk_size]();
+            slot.store(chunk, std::memory_order_release);
+        }
+        chunk[index % chunk_size].store(model, std::memory_order_release);
+        std::unique_lock lock(indices_mutex_);
+        indices_[name] = index;
+    }
+
+    void ModelsStorage::removeModel(const std::string &name)
+    {
+        const auto it = find(name);
+        if (it == end()) return;
+        IModel *model = it->second;
+        erase(it);
+        std::erase_if(deferred_, [&](const auto &m) { return m.first == name; });
+        {
+            std::unique_lock lock(indices_mutex_);
+            const size_t index = indices_.at(name);
+            chunks_[index / chunk_size].load()[index % chunk_size].store(nullptr, std::memory_order_release);
+            indices_.erase(name);
+            /// Кэши индексов в плагинах перечитают индексы
+            generation_ = next_generation++;
+        }
+        G_LOG(0, "Model removed " << name);
+        delete model;
+    }
+
+    std::set<std::string> ModelsStorage::versionConflicts(const std::string &replaced) const
+    {
+        std::unordered_map<std::string, size_t> counts;
+        for (const auto &[model, plugins] : plugins_req_model)
+            if (plugins.size() > plugins.count(replaced)) counts[model.substr(0, model.find_first_of('_'))]++;
+        std::set<std::string> out;
+        for (const auto &[model, count] : counts)
+            if (count > 1) out.insert(model);
+        return out;
+    }
+
+    void ModelsStorage::replacePlugin(const std::string &from, const std::string &to)
+    {
+        for (auto it = plugins_req_model.begin(); it != plugins_req_model.end();) {
+            auto &plugins = it->second;
+            const bool requested = plugins.erase(from) != 0;
+            plugins.erase(to);
+            if (requested && !to.empty()) plugins.insert(to);
+            it = plugins.empty() ? plugins_req_model.erase(it) : std::next(it);
+        }
+    }
+
     ModelsStorage::~ModelsStorage()
     {
         if (!empty()) reset();
+        for (auto &chunk : chunks_) delete[] chunk.load();
+    }
+
+    PersistentRegion *IModel::persistent(const size_t size)
+    {
+        if (region_) {
+            if (region_->size() == size) return region_.get();
+            R_LOG(0, "Persistent region of " << name_ << " already opened with size " << region_->size());
+            return nullptr;
+        }
+        const std::string dir = PersistentRegion::dirFromEnv();
+        if (dir.empty()) return nullptr;
+        region_ = PersistentRegion::open(dir, name_, owner_, size);
+        return region_.get();
+    }
+
+    void ModelsStorage::initModel(IModel *model, const std::string &name)
+    {
+        model->name_ = name;
+        const auto owner = full_names_.find(current_plugin);
+        model->owner_    = owner != full_names_.end() ? owner->second : current_plugin;
+        model->plugin_   = current_plugin;
+        if (memory_) model->memory_ = memory_->model(name, current_plugin);
+        /// Последовательно init() выполняется сразу, если зависимости модели уже инициализированы. Иначе (и всегда
+        /// при MODELS_INIT_THREADS > 1) - на шаге "models init" по уровням графа зависимостей
+        if (init_threads_ > 1 || !dependenciesReady(model)) {
+            deferred_.emplace_back(name, model);
+            return;
+        }
+        Placement::Scope placement(current_plugin);
+        if (!profiler_) {
+            model->init();
+            return;
+        }
+        Profiler::Scope scope(*profiler_, name + "::init", "model");
+        model->init();
+    }
+
+    bool ModelsStorage::dependenciesReady(IModel *model) const
+    {
+        auto cleanName = [](const std::string &name) { return name.substr(0, name.find_first_of('_')); };
+        auto matches   = [&](const std::string &name, const std::string &dep) {
+            return name == dep || cleanName(name) == dep;
+        };
+        for (const auto &dep : model->dependencies()) {
+            if (matches(model->name_, dep)) continue;
+            /// Зависимость ещё не зарегистрирована или её init() сам отложен
+            if (std::none_of(begin(), end(), [&](const auto &m) { return matches(m.first, dep); }) ||
+                std::any_of(deferred_.begin(), deferred_.end(), [&](const auto &m) { return matches(m.first, dep); }))
+                return false;
+        }
+        return true;
+    }
+
+    void ModelsStorage::initDeferred()
+    {
+        if (deferred_.empty()) return;
+        if (init_threads_ > 1)
+            G_LOG(0, "Parallel init of " << deferred_.size() << " models on " << init_threads_ << " threads");
+        else
+            G_LOG(0, "Init of " << deferred_.size() << " models waiting for their dependencies");
+        runLevels(dependencyLevels(deferred_), "init", &IModel::init);
+        deferred_.clear();
+    }
+
+    void ModelsStorage::postInitAll()
+    {
+        runLevels(dependencyLevels(Level(begin(), end())), "postInit", &IModel::postInit);
+    }
+
+    std::vector<ModelsStorage::Level> ModelsStorage::dependencyLevels(const Level &models) const
+    {
+        auto cleanName = [](const std::string &name) { return name.substr(0, name.find_first_of('_')); };
+        auto known     = [&](const std::string &dep) {
+            return contains(dep) || std::any_of(begin(), end(), [&](const auto &m) { return cleanName(m.first) == dep; });
+        };
+        std::unordered_map<std::string, size_t> index;
+        std::unordered_map<std::string, std::vector<size_t>> by_clean_name;
+        for (size_t i = 0; i < models.size(); ++i) {
+            index[models[i].first] = i;
+            by_clean_name[cleanName(models[i].first)].push_back(i);
+        }
+        std::vector<std::vector<size_t>> dependents(models.size());
+        std::vector<size_t> pending(models.size(), 0);
+        for (size_t i = 0; i < models.size(); ++i) {
+            std::set<size_t> deps;
+            for (const auto &dep : models[i].second->dependencies()) {
+                if (const auto it = index.find(dep); it != index.end())
+                    deps.insert(it->second);
+                else if (const auto clean = by_clean_name.find(dep); clean != by_clean_name.end())
+                    deps.insert(clean->second.begin(), clean->second.end());
+                else if (!known(dep))
+                    Y_LOG(0, "Model " << models[i].first << " depends on unknown model " << dep);
+            }
+            deps.erase(i);
+            pending[i] = deps.size();
+            for (const size_t d : deps) dependents[d].push_back(i);
+        }
+        std::vector<Level> levels;
+        std::vector<size_t> current;
+        for (size_t i = 0; i < models.size(); ++i)
+            if (pending[i] == 0) current.push_back(i);
+        size_t done = 0;
+        while (!current.empty()) {
+            Level level;
+            std::vector<size_t> next;
+            for (const size_t i : current) {
+                level.push_back(models[i]);
+                for (const size_t d : dependents[i])
+                    if (--pending[d] == 0) next.push_back(d);
+            }
+            std::sort(level.begin(), level.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+            done += level.size();
+            levels.push_back(std::move(level));
+            current = std::move(next);
+        }
+        if (done != models.size()) {
+            for (size_t i = 0; i < models.size(); ++i)
+                if (pending[i] != 0) R_LOG(0, "Cyclic model dependency involves " << models[i].first);
+            R_LOG(0, "Cyclic dependencies between models detected, cannot initialize");
+            exit(-1);
+        }
+        return levels;
+    }
+
+    void ModelsStorage::runLevels(const std::vector<Level> &levels, const char *stage, void (IModel::*fn)())
+    {
+        for (size_t l = 0; l < levels.size(); ++l) {
+            const auto &level = levels[l];
+            if (levels.size() > 1) G_LOG(0, "[" << stage << " level " << l << "] " << level.size() << " models");
+            parallelFor(level.size(), init_threads_, [&](const size_t i) {
+                const auto &[name, model] = level[i];
+                Placement::Scope placement(model->plugin_);
+                if (!profiler_) {
+                    (model->*fn)();
+                    return;
+                }
+                Profiler::Scope scope(*profiler_, name + "::" + stage, "model");
+                (model->*fn)();
+            });
+        }
     }
 
     void ModelsStorage::reset()
     {
-        for (const int ord : orders)
-            for (auto i = begin(); i != end();)
-                if (i->second->deleteOrder() == ord) {
-                    G_LOG(0, "[DestroyOrder " << ord << "] Destroy " << i->first);
-                    delete i->second;
-                    this->erase(i++);
-                } else
-                    ++i;
+        std::map<int, Level> groups;
+        for (const auto &[name, model] : *this) groups[model->deleteOrder()].emplace_back(name, model);
+        const size_t threads = threadsFromEnv("MODELS_DESTROY_THREADS");
+        Watchdog watchdog(Watchdog::timeoutFromEnv("MODELS_DESTROY_TIMEOUT_MS", std::chrono::milliseconds(0)));
+        for (auto &[ord, group] : groups) {
+            std::sort(group.begin(), group.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+            for (const auto &[name, model] : group) {
+                const size_t index = indices_[name];
+                chunks_[index / chunk_size].load()[index % chunk_size].store(nullptr, std::memory_order_release);
+            }
+            parallelFor(group.size(), threads, [&](const size_t i) {
+                const auto &[name, model] = group[i];
+                G_LOG(0, "[DestroyOrder " << ord << "] Destroy " << name);
+                Watchdog::Guard guard(watchdog, "Destructor of model " + name);
+                delete model;
+            });
+        }
+        clear();
+        std::unique_lock lock(indices_mutex_);
+        indices_.clear();
+        generation_ = next_generation++;
     }
 
     void ModelsStorage::finishRegistering()
@@ -49,7 +273,6 @@ namespace d3156::PluginCore
                 R_LOG(0, "Attention, multiple versions of model '"
                              << count.first << "' detected (" << count.second << " versions). "
                              << "Plugins using different versions cannot communicate with each other");
-        plugins_req_model.clear();
         current_plugin.clear();
     }
 }
\ No newline at end of file
@@ -1,11 +1,20 @@
 #pragma once
 #include "ArgsBuilder/Builder.hpp"
 #include "Logger/Log.hpp"
+#include "Memory/TrackedResource.hpp"
+#include "Persistence/PersistentRegion.hpp"
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <set>
+#include <shared_mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace d3156::PluginCore
 {
+    class Profiler;
 
     class IModel
     {
@@ -23,12 +32,78 @@ namespace d3156::PluginCore
         /// \brief postInit Вызывается после всех шагов инициализации плагинов
         virtual void postInit() {}
 
+        /// \brief dependencies Модели, init и postInit которых должны завершиться раньше, чем у этой модели
+        /// \return Имена моделей: полное name() или имя без версии (часть до первого '_')
+        /// \note Независимые модели одного уровня инициализируются параллельно при MODELS_INIT_THREADS > 1. Иначе
+        /// init() выполняется при регистрации, а модель, зависимости которой ещё не зарегистрированы, - после
+        /// registerModels всех плагинов: registerModel вернёт её до init()
+        virtual std::vector<std::string> dependencies() { return {}; }
+
         /// \brief registerArgs Зарегистрировать аргументы командной строки
         /// \param bldr Анализатор командной строки
         /// \note Значения аргументов распарсятся до postInit
         virtual void registerArgs(Args::Builder &bldr) {}
+
+        /// \brief Ресурс памяти модели: выделения через него учитываются по модели и её плагину (см. Memory)
+        /// \note Ресурс выдаётся после конструктора: используйте его начиная с init() (как и остальные объекты
+        /// модели). Память из него нужно освободить до конца деструктора модели
+        std::pmr::memory_resource *memory() const
+        {
+            return memory_ ? memory_.get() : std::pmr::get_default_resource();
+        }
+
+    protected:
+        /// \brief Память модели, которая переживает перезапуск процесса (см. PersistentRegion)
+        /// \details Вызывается в init(): если attached(), данные прежнего процесса можно подхватить вместо
+        /// построения заново. Область закрывается после деструктора модели, размещённые в ней объекты деструктор
+        /// разрушать не должен. Повторный вызов возвращает ту же область
+        /// \return nullptr, если области отключены, недоступны или size отличается от первого вызова
+        PersistentRegion *persistent(size_t size);
+
+    private:
+        friend class ModelsStorage;
+        std::string name_;   ///< name() модели, задаёт хранилище
+        std::string owner_;  ///< FULL_NAME или имя плагина, создавшего модель (первого по имени среди регистрирующих)
+        std::string plugin_; ///< Плагин, создавший модель: его размещение (Placement) действует в init и postInit
+        std::unique_ptr<PersistentRegion> region_;
+        std::shared_ptr<TrackedResource> memory_;
+    };
+
+    class ModelsStorage;
+    class Memory;
+
+    /// \brief Типизированная ссылка на модель в хранилище: разыменование - обращение к массиву по индексу
+    template <class ConcreteModel> class ModelRef
+    {
+    public:
+        ModelRef() = default;
+
+        /// \return nullptr, если модель не зарегистрирована или уже удалена
+        ConcreteModel *get() const noexcept;
+        ConcreteModel *operator->() const noexcept { return get(); }
+        ConcreteModel &operator*() const noexcept { return *get(); }
+        explicit operator bool() const noexcept { return get() != nullptr; }
+
+    private:
+        friend class ModelsStorage;
+        ModelRef(const ModelsStorage *storage, const size_t index) : storage_(storage), index_(index) {}
+
+        const ModelsStorage *storage_ = nullptr;
+        size_t index_                 = 0;
     };
 
+    namespace
+    {
+        /// Кэш индекса модели типа T. Анонимное пространство имён в открытом заголовке выбрано намеренно: у каждой
+        /// единицы трансляции (и каждого плагина) своя копия кэша, поэтому одноимённые типы разных версий модели в
+        /// разных плагинах не пересекаются.
+        /// Поколение хранилища и индекс упакованы в одно атомарное слово (поколение << index_bits | индекс): get<T>()
+        /// вызывается из потоков плагинов параллельно, и пара должна читаться и записываться целиком
+        template <class ConcreteModel> struct ModelSlot {
+            static inline std::atomic<uint64_t> cached{0};
+        };
+    }
+
     /// \brief Хранилище моделей данных
     class ModelsStorage : protected std::unordered_map<std::string, IModel *>
     {
@@ -36,29 +111,111 @@ namespace d3156::PluginCore
         /// \attention Если модель с таким уже именем есть, она будет возвращена из хранилища. Иначе - создана новая
         template <class ConcreteModel, typename... _Args> ConcreteModel *registerModel(_Args &&...__args)
         {
-            auto it = find(ConcreteModel::name());
-            plugins_req_model[ConcreteModel::name()].insert(current_plugin);
+            const std::string name = ConcreteModel::name();
+            if (on_register_) on_register_(name);
+            auto it = find(name);
+            plugins_req_model[name].insert(current_plugin);
             if (it == end()) {
                 auto model = new ConcreteModel(std::forward<_Args>(__args)...);
-                model->init();
-                orders.insert(model->deleteOrder());
-                insert({ConcreteModel::name(), model});
-                G_LOG(0, "Model registered success [Delete order " << model->deleteOrder() << "] "
-                                                                   << ConcreteModel::name());
+                initModel(model, name);
+                addModel(name, model);
+                G_LOG(0, "Model registered success [Delete order " << model->deleteOrder() << "] " << name);
                 return model;
             }
-            G_LOG(0, "Model already registered :" << ConcreteModel::name() << "\n");
+            G_LOG(0, "Model already registered :" << name << "\n");
             return static_cast<ConcreteModel *>(it->second);
         }
 
+        /// \brief Типизированная ссылка на зарегистрированную модель. Поиск по имени выполняется один раз на тип,
+        /// далее - только обращение к массиву по индексу
+        template <class ConcreteModel> ModelRef<ConcreteModel> ref() const
+        {
+            using Slot      = ModelSlot<ConcreteModel>;
+            uint64_t cached = Slot::cached.load(std::memory_order_acquire);
+            if (cached >> index_bits != (generation_.load(std::memory_order_acquire) & generation_mask)) {
+                std::shared_lock lock(indices_mutex_);
+                const auto it = indices_.find(ConcreteModel::name());
+                if (it == indices_.end()) return {};
+                /// Поколение читается под блокировкой: removeModel меняет его вместе с indices_
+                cached = (generation_.load(std::memory_order_relaxed) & generation_mask) << index_bits | it->second;
+                Slot::cached.store(cached, std::memory_order_release);
+            }
+            return ModelRef<ConcreteModel>(this, cached & index_mask);
+        }
+
+        /// \return Зарегистрированная модель или nullptr
+        template <class ConcreteModel> ConcreteModel *get() const { return ref<ConcreteModel>().get(); }
+
+        /// \brief Модель по индексу регистрации, nullptr - если индекс свободен
+        IModel *at(const size_t index) const noexcept
+        {
+            const auto *chunk = chunks_[index / chunk_size].load(std::memory_order_acquire);
+            return chunk ? chunk[index % chunk_size].load(std::memory_order_acquire) : nullptr;
+        }
+
+        ModelsStorage();
         ~ModelsStorage();
 
     private:
+        using Level = std::vector<std::pair<std::string, IModel *>>;
+
+        void initModel(IModel *model, const std::string &name);
+        /// \return true, если все зависимости модели зарегистрированы и их init() уже выполнен
+        bool dependenciesReady(IModel *model) const;
+        /// \brief Добавить модель в хранилище и выдать ей индекс
+        void addModel(const std::string &name, IModel *model);
+        /// \brief Выполнить отложенные init() по уровням графа зависимостей
+        void initDeferred();
+        /// \brief Вызвать postInit() всех моделей по уровням графа зависимостей
+        void postInitAll();
+        /// \brief Разбить модели на уровни: модели уровня зависят только от моделей предыдущих уровней
+        /// \note При циклической зависимости завершает процесс
+        std::vector<Level> dependencyLevels(const Level &models) const;
+        void runLevels(const std::vector<Level> &levels, const char *stage, void (IModel::*fn)());
         void reset();
         void finishRegistering();
-        std::set<int> orders;
+        /// \brief Удалить модель (откат регистрации при перезагрузке плагина)
+        void removeModel(const std::string &name);
+        /// \brief Проверка finishRegistering без плагина replaced
+        /// \return Имена моделей без версии, которые останутся запрошены в нескольких версиях
+        std::set<std::string> versionConflicts(const std::string &replaced) const;
+        /// \brief Передать запросы моделей плагина from плагину to (пустое to - удалить), прежние запросы to удаляются
+        void replacePlugin(const std::string &from, const std::string &to);
+        Profiler *profiler_ = nullptr;
+        size_t init_threads_;
+        Level deferred_;
         std::string current_plugin;
+        /// Вызывается перед регистрацией модели: Core загружает отложенный плагин, который её предоставляет
+        std::function<void(const std::string &)> on_register_;
+        /// Учёт памяти: выдаёт ресурсы новым моделям
+        Memory *memory_ = nullptr;
+        /// Плагин -> FULL_NAME (или имя, если плагин его не экспортирует): ключ областей PersistentRegion его моделей
+        std::unordered_map<std::string, std::string> full_names_;
+        /// Модель -> плагины, которые её запросили. Сохраняется после запуска для проверки при перезагрузке плагинов
         std::unordered_map<std::string, std::set<std::string>> plugins_req_model;
+
+        /// Плотный реестр: индекс -> модель. Блоки фиксированного размера не перемещаются при добавлении моделей, а
+        /// указатели на блоки атомарны, поэтому чтение по индексу (at()) безопасно параллельно с регистрацией.
+        /// Блоки освобождает деструктор хранилища
+        static constexpr size_t chunk_size = 256;
+        static constexpr size_t max_chunks = 64;
+        std::array<std::atomic<std::atomic<IModel *> *>, max_chunks> chunks_{};
+        /// Упаковка индекса и поколения в ModelSlot
+        static constexpr unsigned index_bits      = 16;
+        static constexpr uint64_t index_mask      = (uint64_t(1) << index_bits) - 1;
+        static constexpr uint64_t generation_mask = ~uint64_t(0) >> index_bits;
+        static_assert(chunk_size * max_chunks <= index_mask + 1, "model index must fit into index_bits");
+        std::unordered_map<std::string, size_t> indices_;
+        /// Защищает indices_: модели могут добавляться и удаляться при перезагрузке плагина
+        mutable std::shared_mutex indices_mutex_;
+        size_t next_index_ = 0;
+        /// Уникален для каждого хранилища и его очистки (и удаления моделей), 0 - не выдаётся
+        std::atomic<uint64_t> generation_;
         friend class Core;
     };
+
+    template <class ConcreteModel> ConcreteModel *ModelRef<ConcreteModel>::get() const noexcept
+    {
+        return storage_ ? static_cast<ConcreteModel *>(storage_->at(index_)) : nullptr;
+    }
 }
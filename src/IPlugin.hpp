@@ -28,5 +28,8 @@ namespace d3156::PluginCore
     IPlugin *create_plugin();
 
     void destroy_plugin(IPlugin *);
+
+    /// Необязательно: FULL_NAME плагина (имя_версия:хэш сборки) для журнала загрузки и манифеста плагинов
+    const char *plugin_full_name();
     }
 }
@@ -0,0 +1,193 @@
+#include "BinaryLog.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <unistd.h>
+
+namespace d3156
+{
+    namespace
+    {
+        template <class V> void put(std::string &out, const V value)
+        {
+            out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+
+        void putString(std::string &out, const char *str)
+        {
+            const auto len = static_cast<uint32_t>(std::strlen(str));
+            put(out, len);
+            out.append(str, len);
+        }
+
+        uint64_t nowNs()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                .count();
+        }
+
+        size_t aligned(const size_t size) { return (size + binary_alignment - 1) & ~(binary_alignment - 1); }
+
+        int64_t steadyNs()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        /// Пауза перед повторным созданием сегмента удваивается после каждой неудачи
+        constexpr std::chrono::nanoseconds min_retry = std::chrono::milliseconds(100);
+        constexpr std::chrono::nanoseconds max_retry = std::chrono::seconds(10);
+    }
+
+    BinaryLog::BinaryLog(std::string dir, std::string format, const size_t segment_size)
+        : dir_(std::move(dir)), format_(std::move(format)), segment_size_(segment_size)
+    {
+        header_size_ = aligned(sizeof(binary_magic) + 2 * sizeof(uint32_t) + format_.size());
+        std::filesystem::create_directories(dir_);
+        std::unique_lock lock(segment_mutex_);
+        rotate();
+    }
+
+    BinaryLog::~BinaryLog()
+    {
+        if (const uint64_t dropped = dropped_.exchange(0))
+            logText(LogType::RED, 0, __FILE__, __LINE__, LOG_NAME,
+                    "Binary log dropped " + std::to_string(dropped) + " records");
+    }
+
+    void BinaryLog::commit(LoggerManager::CallSite &site, std::string &record) noexcept
+    {
+        try {
+            uint32_t id = site.id.load(std::memory_order_acquire);
+            if (id == 0) id = registerSite(site);
+            const uint64_t time = nowNs();
+            std::memcpy(record.data() + 4, &id, sizeof(id));
+            std::memcpy(record.data() + 8, &time, sizeof(time));
+            append(record);
+        } catch (...) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void BinaryLog::logText(const LogType type, const int level, const char *file, const int line,
+                            const char *source, const std::string &message) noexcept
+    {
+        try {
+            std::string record;
+            put(record, uint32_t{0});
+            put(record, binary_inline_site);
+            put(record, nowNs());
+            put(record, static_cast<int32_t>(level));
+            put(record, static_cast<uint8_t>(type));
+            put(record, static_cast<int32_t>(line));
+            putString(record, file);
+            putString(record, source);
+            record.push_back(static_cast<char>(LoggerManager::ArgType::STR));
+            put(record, static_cast<uint32_t>(message.size()));
+            record += message;
+            append(record);
+        } catch (...) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    uint32_t BinaryLog::registerSite(LoggerManager::CallSite &site)
+    {
+        std::lock_guard lock(sites_mutex_);
+        if (const uint32_t id = site.id.load(std::memory_order_acquire)) return id;
+        const uint32_t id = next_id_++;
+        std::string descriptor;
+        put(descriptor, uint32_t{0});
+        put(descriptor, binary_descriptor_site);
+        put(descriptor, id);
+        put(descriptor, static_cast<int32_t>(site.line));
+        put(descriptor, static_cast<uint8_t>(site.type));
+        putString(descriptor, site.file);
+        putString(descriptor, site.source);
+        descriptor.resize(aligned(descriptor.size()), '\0');
+        const auto size = static_cast<uint32_t>(descriptor.size());
+        std::memcpy(descriptor.data(), &size, sizeof(size));
+        {
+            std::lock_guard desc_lock(descriptors_mutex_);
+            descriptors_ += descriptor;
+        }
+        append(descriptor);
+        site.id.store(id, std::memory_order_release);
+        return id;
+    }
+
+    void BinaryLog::append(std::string &record)
+    {
+        record.resize(aligned(record.size()), '\0');
+        const auto size = static_cast<uint32_t>(record.size());
+        if (size + header_size_ > segment_size_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        for (;;) {
+            MappedSegment *expected = nullptr;
+            {
+                std::shared_lock lock(segment_mutex_);
+                expected = segment_.get();
+                if (!expected && steadyNs() < retry_at_.load(std::memory_order_relaxed)) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                if (char *dst = expected ? expected->reserve(size) : nullptr) {
+                    // Размер пишется последним: запись с нулевым размером считается незавершённой
+                    std::memcpy(dst + sizeof(size), record.data() + sizeof(size), size - sizeof(size));
+                    std::atomic_ref<uint32_t>(*reinterpret_cast<uint32_t *>(dst)).store(size,
+                                                                                        std::memory_order_release);
+                    return;
+                }
+            }
+            uint64_t lost = 0;
+            {
+                std::unique_lock lock(segment_mutex_);
+                if (segment_.get() == expected && (expected || steadyNs() >= retry_at_.load())) {
+                    rotate();
+                    if (!expected && segment_) lost = dropped_.exchange(0);
+                }
+                if (!segment_) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            if (lost)
+                logText(LogType::RED, 0, __FILE__, __LINE__, LOG_NAME,
+                        "Binary log dropped " + std::to_string(lost) + " records while no segment could be created");
+        }
+    }
+
+    void BinaryLog::rotate()
+    {
+        segment_.reset();
+        char name[64];
+        std::snprintf(name, sizeof(name), "/binary.%d.%05zu", static_cast<int>(getpid()), sequence_);
+        segment_ = MappedSegment::create(dir_ + name + binary_segment_extension, segment_size_);
+        if (!segment_) {
+            std::cerr << "Logger error: cannot create binary segment in " << dir_ << ": " << std::strerror(errno)
+                      << ", retrying in " << retry_delay_.count() / 1000000 << " ms" << std::endl;
+            retry_at_    = steadyNs() + retry_delay_.count();
+            retry_delay_ = std::min(retry_delay_ * 2, max_retry);
+            return;
+        }
+        sequence_++;
+        retry_delay_ = min_retry;
+        char *header = segment_->reserve(header_size_);
+        const auto format_len = static_cast<uint32_t>(format_.size());
+        std::memcpy(header, binary_magic, sizeof(binary_magic));
+        std::memcpy(header + 4, &binary_version, sizeof(binary_version));
+        std::memcpy(header + 8, &format_len, sizeof(format_len));
+        std::memcpy(header + 12, format_.data(), format_len);
+        std::lock_guard desc_lock(descriptors_mutex_);
+        if (descriptors_.empty()) return;
+        if (char *dst = segment_->reserve(descriptors_.size()))
+            std::memcpy(dst, descriptors_.data(), descriptors_.size());
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "Log.hpp"
+#include "Segment.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+namespace d3156
+{
+    /// Формат сегмента OUT=BINARY:
+    /// заголовок  : magic[4] = "PLOG", version(u32), format_len(u32), FORMAT, выравнивание до 8 байт
+    /// записи     : size(u32, с учётом выравнивания до 8 байт), site(u32), далее по типу записи
+    ///   site == binary_descriptor_site : id(u32) line(i32) type(u8) file(u32 + байты) source(u32 + байты)
+    ///   site == binary_inline_site     : time_ns(u64) level(i32) type(u8) line(i32) file(str) source(str) args
+    ///   иначе (id места вызова)        : time_ns(u64) level(i32) args
+    /// аргумент   : ArgType(u8) + значение; строки — длина(u32) + байты; тег 0 завершает список аргументов
+    constexpr char binary_magic[4]                 = {'P', 'L', 'O', 'G'};
+    constexpr uint32_t binary_version              = 1;
+    constexpr uint32_t binary_descriptor_site      = 0;
+    constexpr uint32_t binary_inline_site          = UINT32_MAX;
+    constexpr size_t binary_alignment              = 8;
+    constexpr const char *binary_segment_extension = ".plog";
+
+    /// \brief Запись лога в отображённые в память сегменты без форматирования на вызывающем потоке
+    class BinaryLog
+    {
+    public:
+        BinaryLog(std::string dir, std::string format, size_t segment_size);
+        ~BinaryLog();
+
+        /// \brief Дописать запись, собранную LoggerManager::BinaryRecord
+        void commit(LoggerManager::CallSite &site, std::string &record) noexcept;
+
+        /// \brief Дописать уже отформатированное сообщение (вызовы LoggerManager::log в обход макросов)
+        void logText(LogType type, int level, const char *file, int line, const char *source,
+                     const std::string &message) noexcept;
+
+    private:
+        uint32_t registerSite(LoggerManager::CallSite &site);
+        void append(std::string &record);
+        void rotate();
+
+        const std::string dir_;
+        const std::string format_;
+        const size_t segment_size_;
+        size_t header_size_ = 0;
+        size_t sequence_    = 0;
+
+        std::shared_mutex segment_mutex_;
+        std::unique_ptr<MappedSegment> segment_;
+        /// Сегмент не создан (диск заполнен, нет дескрипторов): записи отбрасываются, создание повторяется не раньше
+        /// retry_at_ (steady_clock, нс) с нарастающей паузой
+        std::atomic<int64_t> retry_at_{0};
+        std::chrono::nanoseconds retry_delay_{std::chrono::milliseconds(100)};
+
+        std::mutex sites_mutex_;
+        uint32_t next_id_ = 1;
+        std::mutex descriptors_mutex_;
+        std::string descriptors_; ///< Все зарегистрированные дескрипторы для повтора в новом сегменте
+
+        std::atomic<uint64_t> dropped_{0};
+    };
+}
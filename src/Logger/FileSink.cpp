@@ -0,0 +1,119 @@
+#include "FileSink.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace d3156
+{
+    namespace
+    {
+        constexpr std::chrono::seconds retry_interval(1);
+    }
+
+    RotatingFileSink::RotatingFileSink(const std::string &dir, const std::string &name,
+                                       const FileSinkOptions &options)
+        : base_(dir + "/" + name), options_(options)
+    {
+        fs::create_directories(dir);
+        open(true);
+    }
+
+    std::string RotatingFileSink::pathOf(const size_t index) const
+    {
+        return index == 0 ? base_ + ".log" : base_ + "." + std::to_string(index) + ".log";
+    }
+
+    void RotatingFileSink::open(const bool append)
+    {
+        segment_   = MappedSegment::create(pathOf(0), std::max<size_t>(options_.segment_size, 4096), append);
+        opened_at_ = std::chrono::system_clock::now();
+        if (segment_) return;
+        retry_at_ = opened_at_ + retry_interval;
+        std::cerr << "Logger error: cannot map log file " << pathOf(0) << ": " << std::strerror(errno)
+                  << ", lines are dropped until it can be created" << std::endl;
+    }
+
+    void RotatingFileSink::write(const char *data, size_t size, const std::chrono::system_clock::time_point now)
+    {
+        if (!segment_ && now >= retry_at_) open(true);
+        if (segment_ && options_.rotate_interval.count() > 0 && now - opened_at_ >= options_.rotate_interval &&
+            segment_->used() > 0)
+            rotate();
+        // Строка, помещающаяся в сегмент целиком, не разрывается между файлами
+        if (segment_ && segment_->used() + size > segment_->capacity() && size <= options_.segment_size) rotate();
+        while (size > 0 && segment_) {
+            const size_t chunk = std::min(size, segment_->capacity() - segment_->used());
+            if (chunk == 0) {
+                rotate();
+                continue;
+            }
+            std::memcpy(segment_->reserve(chunk), data, chunk);
+            data += chunk;
+            size -= chunk;
+        }
+    }
+
+    void RotatingFileSink::rotate()
+    {
+        segment_.reset();
+        std::error_code ec;
+        size_t last = 0;
+        while (fs::exists(pathOf(last + 1), ec)) ++last;
+        for (size_t i = last; i > 0; --i) fs::rename(pathOf(i), pathOf(i + 1), ec);
+        fs::rename(pathOf(0), pathOf(1), ec);
+        enforceLimit();
+        open(false);
+    }
+
+    void RotatingFileSink::enforceLimit() const
+    {
+        if (options_.max_total == 0) return;
+        std::error_code ec;
+        size_t total = 0;
+        for (size_t i = 1; fs::exists(pathOf(i), ec); ++i) {
+            total += fs::file_size(pathOf(i), ec);
+            if (total > options_.max_total) fs::remove(pathOf(i), ec);
+        }
+    }
+
+    LockedFileSink &SourceSinks::get(const char *source)
+    {
+        const std::string_view name = source;
+        const size_t hash           = std::hash<std::string_view>{}(name);
+        for (size_t i = 0; i < table_size; ++i) {
+            const Slot &slot = table_[(hash + i) % table_size];
+            const char *key  = slot.name.load(std::memory_order_acquire);
+            if (key == nullptr) break;
+            if (slot.hash.load(std::memory_order_relaxed) == hash && name == key)
+                return *slot.sink.load(std::memory_order_relaxed);
+        }
+        return resolve(name, hash);
+    }
+
+    LockedFileSink &SourceSinks::resolve(const std::string_view source, const size_t hash)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = by_name_.find(std::string(source));
+        if (it == by_name_.end())
+            it = by_name_.emplace(source, std::make_unique<LockedFileSink>(dir_, std::string(source), options_)).first;
+        /// Таблица заполняется не больше чем на 3/4, дальше новые имена ищутся под блокировкой
+        if (used_ >= table_size * 3 / 4) return *it->second;
+        for (size_t i = 0; i < table_size; ++i) {
+            Slot &slot      = table_[(hash + i) % table_size];
+            const char *key = slot.name.load(std::memory_order_relaxed);
+            if (key == it->first.c_str()) break;
+            if (key != nullptr) continue;
+            slot.hash.store(hash, std::memory_order_relaxed);
+            slot.sink.store(it->second.get(), std::memory_order_relaxed);
+            slot.name.store(it->first.c_str(), std::memory_order_release);
+            used_++;
+            break;
+        }
+        return *it->second;
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include "Segment.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace d3156
+{
+    struct FileSinkOptions {
+        size_t segment_size = 64u << 20;         ///< Размер предварительно выделенного сегмента (LOG_SEGMENT_SIZE)
+        std::chrono::seconds rotate_interval{0}; ///< Ротация по времени, 0 - отключена (LOG_ROTATE_SEC)
+        size_t max_total = 0; ///< Предел суммарного размера архивных файлов источника, 0 - без предела (LOG_MAX_TOTAL)
+    };
+
+    /// \brief Текстовый лог-файл dir/name.log, отображённый в память, с ротацией по размеру и времени
+    /// \details При ротации файлы сдвигаются: name.log -> name.1.log -> name.2.log ..., самые старые удаляются,
+    /// пока суммарный размер архивных файлов превышает max_total.
+    /// Если файл не удалось создать (диск заполнен, исчерпаны дескрипторы), строки отбрасываются, а попытка
+    /// повторяется не чаще раза в секунду.
+    /// \note Не потокобезопасен, вызывающий сериализует write()
+    class RotatingFileSink
+    {
+    public:
+        RotatingFileSink(const std::string &dir, const std::string &name, const FileSinkOptions &options);
+
+        void write(const char *data, size_t size, std::chrono::system_clock::time_point now);
+
+    private:
+        std::string pathOf(size_t index) const;
+        void open(bool append);
+        void rotate();
+        void enforceLimit() const;
+
+        const std::string base_;
+        const FileSinkOptions options_;
+        std::unique_ptr<MappedSegment> segment_;
+        std::chrono::system_clock::time_point opened_at_;
+        std::chrono::system_clock::time_point retry_at_; ///< Не открытый сегмент создаётся заново не раньше
+    };
+
+    /// \brief Файл со своей блокировкой: файлы разных источников пишутся без общей блокировки
+    class LockedFileSink
+    {
+    public:
+        LockedFileSink(const std::string &dir, const std::string &name, const FileSinkOptions &options)
+            : file_(dir, name, options)
+        {
+        }
+
+        void write(const char *data, const size_t size, const std::chrono::system_clock::time_point now)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            file_.write(data, size, now);
+        }
+
+    private:
+        std::mutex mutex_;
+        RotatingFileSink file_;
+    };
+
+    /// \brief Файлы источников для PER_SOURCE_FILES: dir/{source}.log
+    /// \details Источник ищется по содержимому LOG_NAME (хеш и сравнение строк) в таблице с открытой адресацией без
+    /// блокировок. Ключом служит собственная копия имени, а не указатель: после выгрузки библиотеки её адрес может
+    /// занять другая строка. Источники с одинаковым именем из разных библиотек получают один файл
+    class SourceSinks
+    {
+    public:
+        SourceSinks(std::string dir, const FileSinkOptions &options) : dir_(std::move(dir)), options_(options) {}
+
+        LockedFileSink &get(const char *source);
+
+    private:
+        LockedFileSink &resolve(std::string_view source, size_t hash);
+
+        static constexpr size_t table_size = 1024;
+        struct Slot {
+            std::atomic<const char *> name{nullptr}; ///< Копия имени из by_name_, публикуется после hash и sink
+            std::atomic<size_t> hash{0};
+            std::atomic<LockedFileSink *> sink{nullptr};
+        };
+
+        const std::string dir_;
+        const FileSinkOptions options_;
+        std::array<Slot, table_size> table_;
+        std::mutex mutex_; ///< Только для нового имени
+        size_t used_ = 0;
+        std::unordered_map<std::string, std::unique_ptr<LockedFileSink>> by_name_;
+    };
+}
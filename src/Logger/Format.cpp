@@ -0,0 +1,120 @@
+#include "Format.hpp"
+#include <charconv>
+#include <ctime>
+
+namespace d3156
+{
+    namespace
+    {
+        /// Кэш strftime на текущую секунду, свой у каждого потока
+        struct DateCache {
+            const void *owner = nullptr;
+            time_t second     = -1;
+            std::vector<std::string> values;
+        };
+
+        thread_local DateCache date_cache;
+
+        void appendInt(std::string &out, const int value)
+        {
+            char buf[16];
+            const auto res = std::to_chars(buf, buf + sizeof(buf), value);
+            out.append(buf, res.ptr);
+        }
+    }
+
+    LogFormat::LogFormat(const std::string &format)
+    {
+        auto addLiteral = [this](std::string_view text) {
+            if (text.empty()) return;
+            if (!tokens_.empty() && tokens_.back().kind == Kind::LITERAL)
+                tokens_.back().text += text;
+            else
+                tokens_.push_back({Kind::LITERAL, std::string(text)});
+        };
+        size_t pos = 0;
+        while (pos < format.size()) {
+            const size_t open = format.find('{', pos);
+            if (open == std::string::npos) break;
+            const size_t close = format.find('}', open);
+            if (close == std::string::npos) break;
+            addLiteral(std::string_view(format).substr(pos, open - pos));
+            const std::string_view name = std::string_view(format).substr(open + 1, close - open - 1);
+            if (name == "source")
+                tokens_.push_back({Kind::SOURCE, {}});
+            else if (name == "file")
+                tokens_.push_back({Kind::FILE, {}});
+            else if (name == "line")
+                tokens_.push_back({Kind::LINE, {}});
+            else if (name == "level")
+                tokens_.push_back({Kind::LEVEL, {}});
+            else if (name == "message")
+                tokens_.push_back({Kind::MESSAGE, {}});
+            else if (name.starts_with("date:"))
+                tokens_.push_back({Kind::DATE, std::string(name.substr(5)), date_count_++});
+            else
+                addLiteral(std::string_view(format).substr(open, close - open + 1));
+            pos = close + 1;
+        }
+        addLiteral(std::string_view(format).substr(pos));
+    }
+
+    void LogFormat::renderDates(const std::chrono::system_clock::time_point time) const
+    {
+        const time_t t_c = std::chrono::system_clock::to_time_t(time);
+        if (date_cache.owner == this && date_cache.second == t_c) return;
+        std::tm tm{};
+        localtime_r(&t_c, &tm);
+        date_cache.values.resize(date_count_);
+        for (const auto &token : tokens_) {
+            if (token.kind != Kind::DATE) continue;
+            char buf[64];
+            const size_t len = strftime(buf, sizeof(buf), token.text.c_str(), &tm);
+            date_cache.values[token.date_idx].assign(buf, len);
+        }
+        date_cache.owner  = this;
+        date_cache.second = t_c;
+    }
+
+    void LogFormat::render(std::string &out, const LogRecord &rec, const bool colored) const
+    {
+        render(out, rec.type, rec.level, rec.file, rec.line, rec.source, rec.message, rec.time, colored);
+    }
+
+    void LogFormat::render(std::string &out, const LogType type, const int level, const char *file, const int line,
+                           const char *source, const std::string_view message,
+                           const std::chrono::system_clock::time_point time, const bool colored) const
+    {
+        if (date_count_) renderDates(time);
+        for (const auto &token : tokens_) {
+            switch (token.kind) {
+                case Kind::LITERAL: out += token.text; break;
+                case Kind::DATE: out += date_cache.values[token.date_idx]; break;
+                case Kind::SOURCE:
+                    if (colored) {
+                        switch (type) {
+                            case LogType::RED: out += "\033[31m"; break;
+                            case LogType::YELLOW: out += "\033[33m"; break;
+                            case LogType::GREEN: out += "\033[32m"; break;
+                            case LogType::WHITE: out += "\033[0m"; break;
+                        }
+                        out += source;
+                        out += "\033[0m";
+                    } else {
+                        switch (type) {
+                            case LogType::RED: out += "RED_"; break;
+                            case LogType::YELLOW: out += "YELLOW_"; break;
+                            case LogType::GREEN: out += "GREEN_"; break;
+                            case LogType::WHITE: break;
+                        }
+                        out += source;
+                    }
+                    break;
+                case Kind::FILE: out += file; break;
+                case Kind::LINE: appendInt(out, line); break;
+                case Kind::LEVEL: appendInt(out, level); break;
+                case Kind::MESSAGE: out += message; break;
+            }
+        }
+    }
+}
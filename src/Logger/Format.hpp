@@ -0,0 +1,51 @@
+#pragma once
+#include "Log.hpp"
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace d3156
+{
+    /// \brief Запись лога, передаваемая от вызывающего потока к выводу
+    struct LogRecord {
+        LogType type;
+        int level;
+        const char *file;
+        int line;
+        const char *source;
+        std::string message;
+        std::chrono::system_clock::time_point time;
+    };
+
+    /// \brief Предварительно разобранный шаблон FORMAT
+    /// \details Шаблон разбирается один раз в список токенов. Подстановка значений выполняется за один проход,
+    /// поэтому плейсхолдеры внутри самого сообщения не раскрываются.
+    class LogFormat
+    {
+    public:
+        explicit LogFormat(const std::string &format);
+
+        /// \brief Дописать отформатированную запись в out (без перевода строки)
+        /// \param colored Выделять {source} цветом (консоль), иначе добавлять префикс типа (файл)
+        void render(std::string &out, const LogRecord &rec, bool colored) const;
+
+        /// \brief Дописать отформатированную запись в out (без перевода строки)
+        void render(std::string &out, LogType type, int level, const char *file, int line, const char *source,
+                    std::string_view message, std::chrono::system_clock::time_point time, bool colored) const;
+
+    private:
+        enum class Kind : uint8_t { LITERAL, DATE, SOURCE, FILE, LINE, LEVEL, MESSAGE };
+
+        struct Token {
+            Kind kind;
+            std::string text; ///< Литерал или strftime-спецификация для {date:...}
+            size_t date_idx = 0;
+        };
+
+        void renderDates(std::chrono::system_clock::time_point time) const;
+
+        std::vector<Token> tokens_;
+        size_t date_count_ = 0;
+    };
+}
@@ -1,15 +1,23 @@
 #include "Log.hpp"
+#include "BinaryLog.hpp"
+#include "FileSink.hpp"
+#include "Format.hpp"
+#include "Utils/MpmcQueue.hpp"
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdlib>
 #include <cstring>
-#include <filesystem>
-#include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
-#include <regex>
 #include <sstream>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 namespace d3156
 {
@@ -30,32 +38,101 @@ namespace d3156
         return def;
     }
 
-    enum class OutType { CONSOLE, FILE };
+    size_t getSizeFromEnv(const char *env, const size_t def)
+    {
+        if (const char *val = getenv(env)) {
+            try {
+                return static_cast<size_t>(std::stoull(val));
+            } catch (...) {
+            }
+        }
+        return def;
+    }
+
+    enum class OutType { CONSOLE, FILE, BINARY };
 
     OutType getOutType()
     {
         const char *val = getenv("OUT");
-        return (val && std::strncmp(val, "FILE", 5) == 0) ? OutType::FILE : OutType::CONSOLE;
+        if (val && std::strncmp(val, "FILE", 5) == 0) return OutType::FILE;
+        if (val && std::strncmp(val, "BINARY", 7) == 0) return OutType::BINARY;
+        return OutType::CONSOLE;
+    }
+
+    const char *toString(const OutType out)
+    {
+        switch (out) {
+            case OutType::CONSOLE: return "CONSOLE";
+            case OutType::FILE: return "FILE";
+            case OutType::BINARY: return "BINARY";
+        }
+        return "";
+    }
+
+    enum class LogMode { SYNC, ASYNC };
+
+    LogMode getLogMode()
+    {
+        const char *val = getenv("LOG_MODE");
+        return (val && std::strncmp(val, "ASYNC", 6) == 0) ? LogMode::ASYNC : LogMode::SYNC;
+    }
+
+    enum class OverflowPolicy { BLOCK, DROP_NEWEST, DROP_OLDEST };
+
+    OverflowPolicy getOverflowPolicy()
+    {
+        const char *val = getenv("LOG_OVERFLOW");
+        if (val && std::strncmp(val, "DROP_NEWEST", 12) == 0) return OverflowPolicy::DROP_NEWEST;
+        if (val && std::strncmp(val, "DROP_OLDEST", 12) == 0) return OverflowPolicy::DROP_OLDEST;
+        return OverflowPolicy::BLOCK;
+    }
+
+    const char *toString(const OverflowPolicy policy)
+    {
+        switch (policy) {
+            case OverflowPolicy::BLOCK: return "BLOCK";
+            case OverflowPolicy::DROP_NEWEST: return "DROP_NEWEST";
+            case OverflowPolicy::DROP_OLDEST: return "DROP_OLDEST";
+        }
+        return "";
     }
 
     static std::string FORMAT  = getenv("FORMAT") ? getenv("FORMAT") : "|{date:%H:%M:%S}|{source}| {message}";
     static OutType OUT         = getOutType();
     static std::string OUT_DIR = getenv("OUT_DIR") ? getenv("OUT_DIR") : "./logs";
     static std::atomic<bool> PER_SOURCE_FILES = getBoolEnv("PER_SOURCE_FILES", false);
-    static std::atomic<u_int16_t> R_LEVEL     = getFromEnv("R_LEVEL", 1);
-    static std::atomic<u_int16_t> Y_LEVEL     = getFromEnv("Y_LEVEL", 1);
-    static std::atomic<u_int16_t> G_LEVEL     = getFromEnv("G_LEVEL", 1);
-    static std::atomic<u_int16_t> W_LEVEL     = getFromEnv("W_LEVEL", 1);
+    static LogMode MODE                       = getLogMode();
+    static OverflowPolicy OVERFLOW_POLICY     = getOverflowPolicy();
+    static size_t QUEUE_SIZE                  = getSizeFromEnv("LOG_QUEUE_SIZE", 65536);
+    static size_t SEGMENT_SIZE                = getSizeFromEnv("LOG_SEGMENT_SIZE", 64u << 20);
+    static size_t ROTATE_SEC                  = getSizeFromEnv("LOG_ROTATE_SEC", 0);
+    static size_t MAX_TOTAL                   = getSizeFromEnv("LOG_MAX_TOTAL", 0);
+    static std::chrono::milliseconds REPEAT_WINDOW(getSizeFromEnv("LOG_REPEAT_MS", 0));
 
-    bool LoggerManager::allowed(const LogType type, const int level) noexcept
+    std::atomic<bool> LoggerManager::binary = OUT == OutType::BINARY;
+
+    constexpr uint64_t packLevel(const LogType type, const u_int16_t level)
     {
-        switch (type) {
-            case LogType::RED: return level <= R_LEVEL;
-            case LogType::YELLOW: return level <= Y_LEVEL;
-            case LogType::GREEN: return level <= G_LEVEL;
-            case LogType::WHITE: return level <= W_LEVEL;
-        }
-        return false;
+        return static_cast<uint64_t>(level) << (16 * static_cast<unsigned>(type));
+    }
+
+    std::atomic<uint64_t> LoggerManager::levels =
+        packLevel(LogType::RED, getFromEnv("R_LEVEL", 1)) | packLevel(LogType::YELLOW, getFromEnv("Y_LEVEL", 1)) |
+        packLevel(LogType::GREEN, getFromEnv("G_LEVEL", 1)) | packLevel(LogType::WHITE, getFromEnv("W_LEVEL", 1));
+
+    static u_int16_t levelOf(const LogType type)
+    {
+        return (LoggerManager::levels.load(std::memory_order_relaxed) >> (16 * static_cast<unsigned>(type))) & 0xFFFF;
+    }
+
+    bool LoggerManager::allowed(const LogType type, const int level) noexcept { return enabled(type, level); }
+
+    void LoggerManager::setLevel(const LogType type, const uint16_t level) noexcept
+    {
+        const uint64_t mask = packLevel(type, 0xFFFF);
+        uint64_t word       = levels.load(std::memory_order_relaxed);
+        while (!levels.compare_exchange_weak(word, (word & ~mask) | packLevel(type, level), std::memory_order_relaxed))
+            ;
     }
 
     namespace
@@ -63,7 +140,7 @@ namespace d3156
         class LoggerImpl
         {
         public:
-            LoggerImpl()
+            LoggerImpl() : format_(FORMAT)
             {
                 constexpr int width = 80;
                 std::cout << "\033[1;32mLogger Settings from process Environment\033[0m" << std::endl;
@@ -72,112 +149,325 @@ namespace d3156
                     << "\033[34mFORMAT\033[0m           : " << FORMAT
                     << "\033[32m # allow {source}, {file}, {line}, {message}, {date:format strftime}, {level}\033[0m"
                     << std::endl;
-                std::cout << "\033[34mOUT\033[0m              : " << (OUT == OutType::FILE ? "FILE" : "CONSOLE")
-                          << " \033[32m# allow FILE and CONSOLE\033[0m" << std::endl;
+                std::cout << "\033[34mOUT\033[0m              : " << toString(OUT)
+                          << " \033[32m# allow FILE, CONSOLE and BINARY (decode with plog-decode)\033[0m" << std::endl;
                 std::cout << "\033[34mOUT_DIR\033[0m          : " << OUT_DIR << std::endl;
                 std::cout << "\033[34mPER_SOURCE_FILES\033[0m : " << (PER_SOURCE_FILES ? "true" : "false")
                           << " \033[32m# Save logs in files OUT_DIR/{source}.log\033[0m" << std::endl;
-                std::cout << "\033[34mR_LEVEL\033[0m          : " << R_LEVEL << std::endl;
-                std::cout << "\033[34mY_LEVEL\033[0m          : " << Y_LEVEL << std::endl;
-                std::cout << "\033[34mG_LEVEL\033[0m          : " << G_LEVEL << std::endl;
-                std::cout << "\033[34mW_LEVEL\033[0m          : " << W_LEVEL << std::endl;
+                std::cout << "\033[34mR_LEVEL\033[0m          : " << levelOf(LogType::RED) << std::endl;
+                std::cout << "\033[34mY_LEVEL\033[0m          : " << levelOf(LogType::YELLOW) << std::endl;
+                std::cout << "\033[34mG_LEVEL\033[0m          : " << levelOf(LogType::GREEN) << std::endl;
+                std::cout << "\033[34mW_LEVEL\033[0m          : " << levelOf(LogType::WHITE) << std::endl;
+                std::cout << "\033[34mLOG_REPEAT_MS\033[0m    : " << REPEAT_WINDOW.count()
+                          << " \033[32m# Collapse repeated messages of a call site, 0 - disabled\033[0m" << std::endl;
+                std::cout << "\033[34mLOG_MODE\033[0m         : " << (MODE == LogMode::ASYNC ? "ASYNC" : "SYNC")
+                          << " \033[32m# allow SYNC and ASYNC (background writer thread)\033[0m" << std::endl;
+                if (MODE == LogMode::ASYNC) {
+                    std::cout << "\033[34mLOG_QUEUE_SIZE\033[0m   : " << QUEUE_SIZE << std::endl;
+                    std::cout << "\033[34mLOG_OVERFLOW\033[0m     : " << toString(OVERFLOW_POLICY)
+                              << " \033[32m# allow BLOCK, DROP_NEWEST, DROP_OLDEST\033[0m" << std::endl;
+                }
+                if (OUT == OutType::BINARY)
+                    std::cout << "\033[34mLOG_SEGMENT_SIZE\033[0m : " << SEGMENT_SIZE
+                              << " \033[32m# Segments OUT_DIR/binary.{pid}.{n}.plog\033[0m" << std::endl;
+                if (OUT == OutType::FILE) {
+                    std::cout << "\033[34mLOG_SEGMENT_SIZE\033[0m : " << SEGMENT_SIZE
+                              << " \033[32m# Rotate {source}.log -> {source}.1.log when full\033[0m" << std::endl;
+                    std::cout << "\033[34mLOG_ROTATE_SEC\033[0m   : " << ROTATE_SEC
+                              << " \033[32m# Rotate by time, 0 - disabled\033[0m" << std::endl;
+                    std::cout << "\033[34mLOG_MAX_TOTAL\033[0m    : " << MAX_TOTAL
+                              << " \033[32m# Max bytes of rotated files per source, 0 - unlimited\033[0m" << std::endl;
+                }
                 std::cout << std::string(width, '=') << std::endl;
-                if (OUT == OutType::FILE && !PER_SOURCE_FILES) {
-                    std::filesystem::create_directories(OUT_DIR);
-                    common_file_.open(OUT_DIR + "/common.log", std::ios::app);
+                if (OUT == OutType::BINARY) {
+                    binary_ = std::make_unique<BinaryLog>(OUT_DIR, FORMAT, SEGMENT_SIZE);
+                    return;
+                }
+                file_options_.segment_size    = SEGMENT_SIZE;
+                file_options_.rotate_interval = std::chrono::seconds(ROTATE_SEC);
+                file_options_.max_total       = MAX_TOTAL;
+                if (OUT == OutType::FILE && !PER_SOURCE_FILES)
+                    common_file_ = std::make_unique<LockedFileSink>(OUT_DIR, "common", file_options_);
+                if (OUT == OutType::FILE && PER_SOURCE_FILES)
+                    source_files_ = std::make_unique<SourceSinks>(OUT_DIR, file_options_);
+                if (MODE == LogMode::ASYNC) {
+                    queue_  = std::make_unique<MpmcQueue<LogRecord>>(QUEUE_SIZE);
+                    writer_ = std::thread([this] { writerLoop(); });
                 }
             }
 
+            ~LoggerImpl()
+            {
+                /// thread_local главного потока (буферы форматирования) к этому моменту уже разрушены, поэтому
+                /// оставшиеся повторы выводятся из отдельного потока
+                if (REPEAT_WINDOW.count() > 0 && pendingRepeats()) std::thread([this] { flushRepeats(); }).join();
+                if (!writer_.joinable()) return;
+                stop_ = true;
+                wake();
+                writer_.join();
+            }
+
             void log(LogType type, int level, const char *file, int line, const char *source,
-                     const std::string &message) noexcept
+                     std::string &&message) noexcept
             {
-                try {
-                    std::ostringstream oss;
-                    std::string formatted = FORMAT;
-                    // --- handle {date:...} ---
-                    std::regex date_regex(R"(\{date:(.*?)\})");
-                    std::smatch match;
-                    auto f_start = formatted.cbegin();
-                    while (std::regex_search(f_start, formatted.cend(), match, date_regex)) {
-                        auto now = std::chrono::system_clock::now();
-                        auto t_c = std::chrono::system_clock::to_time_t(now);
-                        std::tm tm{};
-                        localtime_r(&t_c, &tm);
-
-                        char buf[64];
-                        strftime(buf, sizeof(buf), match[1].str().c_str(), &tm);
-                        formatted.replace(match.position(0), match.length(0), buf);
-                        f_start = formatted.cbegin() + match.position(0) + std::strlen(buf);
+                if (REPEAT_WINDOW.count() > 0 && repeated(type, level, file, line, source, message)) return;
+                emit(type, level, file, line, source, std::move(message));
+            }
+
+            void commit(LoggerManager::CallSite &site, std::string &record) noexcept
+            {
+                if (binary_) binary_->commit(site, record);
+            }
+
+            /// Ждёт, пока фоновый поток запишет все поставленные в очередь записи
+            void flush() noexcept
+            {
+                if (REPEAT_WINDOW.count() > 0) flushRepeats();
+                if (!queue_ || !writer_.joinable()) return;
+                const uint64_t target = pushed_.load(std::memory_order_acquire);
+                while (done_.load(std::memory_order_acquire) < target) {
+                    wake();
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                }
+            }
+
+        private:
+            /// Последнее сообщение места вызова и число его повторов с прошлого вывода
+            struct RepeatSlot {
+                std::mutex mutex;
+                const char *file   = nullptr;
+                int line           = 0;
+                size_t hash        = 0;
+                std::string message; ///< Текст сравнивается целиком: совпадение хеша не означает повтор
+                LogType type       = LogType::WHITE;
+                int level          = 0;
+                const char *source = nullptr;
+                uint64_t repeats   = 0;
+                std::chrono::steady_clock::time_point last;     ///< Последнее появление
+                std::chrono::steady_clock::time_point reported; ///< Последний вывод сообщения или сводки
+            };
+
+            /// \return true, если сообщение повторяет предыдущее с того же места и не выводится. Повторы
+            /// сводятся в "last message repeated N times": раз в REPEAT_WINDOW, при другом сообщении с этого места и
+            /// при flush. Сообщение после паузы дольше окна выводится как обычно. Включается LOG_REPEAT_MS > 0:
+            /// по умолчанию выключено, и строки не проходят через хеш и блокировку ячейки
+            bool repeated(const LogType type, const int level, const char *file, const int line, const char *source,
+                          const std::string &message) noexcept
+            {
+                const size_t hash  = std::hash<std::string_view>{}(message);
+                const uint64_t key = reinterpret_cast<uintptr_t>(file) ^ static_cast<uint64_t>(line);
+                /// Старшие 8 бит мультипликативного хеша - индекс среди 256 ячеек
+                RepeatSlot &slot = repeat_slots_[(key * 0x9E3779B97F4A7C15ULL) >> 56];
+                std::lock_guard<std::mutex> lock(slot.mutex);
+                const auto now = std::chrono::steady_clock::now();
+                if (slot.file == file && slot.line == line && slot.hash == hash && slot.message == message) {
+                    if (slot.repeats == 0 && now - slot.last >= REPEAT_WINDOW) {
+                        slot.last = slot.reported = now;
+                        return false;
                     }
-                    std::string color;
-                    if (OUT == OutType::CONSOLE) {
-                        switch (type) {
-                            case LogType::RED: color = "\033[31m"; break;
-                            case LogType::YELLOW: color = "\033[33m"; break;
-                            case LogType::GREEN: color = "\033[32m"; break;
-                            case LogType::WHITE: color = "\033[0m"; break;
+                    slot.repeats++;
+                    slot.last = now;
+                    if (now - slot.reported >= REPEAT_WINDOW) {
+                        reportRepeats(slot);
+                        slot.reported = now;
+                    }
+                    return true;
+                }
+                if (slot.repeats) reportRepeats(slot);
+                slot.file   = file;
+                slot.line   = line;
+                slot.hash   = hash;
+                slot.message.assign(message);
+                slot.type   = type;
+                slot.level  = level;
+                slot.source = source;
+                slot.last = slot.reported = now;
+                return false;
+            }
+
+            void reportRepeats(RepeatSlot &slot) noexcept
+            {
+                emit(slot.type, slot.level, slot.file, slot.line, slot.source,
+                     "last message repeated " + std::to_string(slot.repeats) + " times");
+                slot.repeats = 0;
+            }
+
+            bool pendingRepeats() noexcept
+            {
+                return std::any_of(repeat_slots_.begin(), repeat_slots_.end(), [](RepeatSlot &slot) {
+                    std::lock_guard<std::mutex> lock(slot.mutex);
+                    return slot.repeats != 0;
+                });
+            }
+
+            void flushRepeats() noexcept
+            {
+                for (auto &slot : repeat_slots_) {
+                    std::lock_guard<std::mutex> lock(slot.mutex);
+                    if (slot.repeats) reportRepeats(slot);
+                }
+            }
+
+            void emit(LogType type, int level, const char *file, int line, const char *source,
+                      std::string &&message) noexcept
+            {
+                if (binary_) {
+                    binary_->logText(type, level, file, line, source, message);
+                    return;
+                }
+                LogRecord rec{type, level, file, line, source, std::move(message), std::chrono::system_clock::now()};
+                if (!queue_) {
+                    write(rec, true);
+                    return;
+                }
+                push(std::move(rec));
+            }
+
+            void push(LogRecord &&rec) noexcept
+            {
+                switch (OVERFLOW_POLICY) {
+                    case OverflowPolicy::BLOCK:
+                        while (!queue_->tryPush(std::move(rec))) {
+                            wake();
+                            std::this_thread::yield();
                         }
-                        replace_all(formatted, "{source}", color + source + "\033[0m");
-                    } else {
-                        switch (type) {
-                            case LogType::RED: color = "RED_"; break;
-                            case LogType::YELLOW: color = "YELLOW_"; break;
-                            case LogType::GREEN: color = "GREEN_"; break;
-                            case LogType::WHITE: color = ""; break;
+                        break;
+                    case OverflowPolicy::DROP_NEWEST:
+                        if (!queue_->tryPush(std::move(rec))) {
+                            dropped_.fetch_add(1, std::memory_order_relaxed);
+                            return;
                         }
-                        replace_all(formatted, "{source}", color + source);
+                        break;
+                    case OverflowPolicy::DROP_OLDEST: {
+                        LogRecord old;
+                        while (!queue_->tryPush(std::move(rec)))
+                            if (queue_->tryPop(old)) {
+                                dropped_.fetch_add(1, std::memory_order_relaxed);
+                                done_.fetch_add(1, std::memory_order_release);
+                            }
+                        break;
                     }
-                    // --- replace other placeholders ---
-                    replace_all(formatted, "{file}", file);
-                    replace_all(formatted, "{line}", std::to_string(line));
-                    replace_all(formatted, "{message}", message);
-                    replace_all(formatted, "{level}", std::to_string(level));
+                }
+                pushed_.fetch_add(1, std::memory_order_release);
+                if (sleeping_.load()) wake();
+            }
 
-                    // --- output ---
-                    if (OUT == OutType::CONSOLE) {
-                        std::cout << formatted << std::endl;
-                    } else {
-                        std::ofstream *out_file = getFileStream(source);
-                        std::lock_guard<std::mutex> lock(file_mutex_);
-                        (*out_file) << formatted << std::endl;
+            void wake()
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex_);
+                wake_cv_.notify_one();
+            }
+
+            void writerLoop()
+            {
+                constexpr size_t batch_size = 1024;
+                std::vector<LogRecord> batch;
+                batch.reserve(batch_size);
+                LogRecord rec;
+                for (;;) {
+                    while (batch.size() < batch_size && queue_->tryPop(rec)) batch.push_back(std::move(rec));
+                    if (batch.empty()) {
+                        if (stop_ && queue_->sizeApprox() == 0) break;
+                        std::unique_lock<std::mutex> lock(wake_mutex_);
+                        sleeping_.store(true);
+                        if (queue_->sizeApprox() == 0 && !stop_)
+                            wake_cv_.wait_for(lock, std::chrono::milliseconds(50));
+                        sleeping_.store(false);
+                        continue;
                     }
-                } catch (...) {
-                    std::cout << "Logger error";
+                    for (const auto &r : batch) write(r, false);
+                    if (const uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed))
+                        write({LogType::RED, 0, __FILE__, __LINE__, LOG_NAME,
+                               "Logger queue overflow, dropped " + std::to_string(dropped) + " records",
+                               std::chrono::system_clock::now()},
+                              false);
+                    flushStreams();
+                    done_.fetch_add(batch.size(), std::memory_order_release);
+                    batch.clear();
                 }
+                flushStreams();
             }
 
-        private:
-            std::ofstream *getFileStream(const char *source)
+            /// Файлы отображены в память и не требуют сброса
+            static void flushStreams()
             {
-                if (!PER_SOURCE_FILES) return &common_file_;
-                std::lock_guard<std::mutex> lock(file_mutex_);
-                auto it = file_streams_.find(source);
-                if (it != file_streams_.end()) return &it->second;
-                auto &ofs        = file_streams_[source];
-                std::string path = OUT_DIR + "/" + source + ".log";
-                ofs.open(path, std::ios::app);
-                return &ofs;
+                if (OUT == OutType::CONSOLE) std::cout.flush();
             }
 
-            static void replace_all(std::string &str, const std::string &from, const std::string &to)
+            /// \param sync Сбрасывать консоль после каждой строки (синхронный режим)
+            void write(const LogRecord &rec, const bool sync) noexcept
             {
-                size_t start = 0;
-                while ((start = str.find(from, start)) != std::string::npos) {
-                    str.replace(start, from.length(), to);
-                    start += to.length();
+                try {
+                    thread_local std::string formatted;
+                    formatted.clear();
+                    format_.render(formatted, rec, OUT == OutType::CONSOLE);
+
+                    // --- output ---
+                    formatted += '\n';
+                    if (OUT == OutType::CONSOLE) {
+                        std::cout << formatted;
+                        if (sync) std::cout.flush();
+                    } else {
+                        LockedFileSink *out_file = source_files_ ? &source_files_->get(rec.source) : common_file_.get();
+                        if (out_file) out_file->write(formatted.data(), formatted.size(), rec.time);
+                    }
+                } catch (...) {
+                    std::cout << "Logger error";
                 }
             }
 
-            std::mutex file_mutex_;
-            std::ofstream common_file_;
-            std::unordered_map<std::string, std::ofstream> file_streams_;
+            const LogFormat format_;
+            std::unique_ptr<BinaryLog> binary_;
+            FileSinkOptions file_options_;
+            std::unique_ptr<LockedFileSink> common_file_;
+            std::unique_ptr<SourceSinks> source_files_; ///< PER_SOURCE_FILES
+            std::array<RepeatSlot, 256> repeat_slots_;
+
+            // --- async mode ---
+            std::unique_ptr<MpmcQueue<LogRecord>> queue_;
+            std::thread writer_;
+            std::mutex wake_mutex_;
+            std::condition_variable wake_cv_;
+            std::atomic<bool> sleeping_{false};
+            std::atomic<bool> stop_{false};
+            std::atomic<uint64_t> pushed_{0};
+            std::atomic<uint64_t> done_{0};
+            std::atomic<uint64_t> dropped_{0};
         };
+
+        LoggerImpl &impl()
+        {
+            static LoggerImpl impl;
+            return impl;
+        }
     }
 
     void LoggerManager::log(const LogType type, const int level, const char *file, const int line, const char *source,
                             std::string &&message) noexcept
     {
-        static LoggerImpl impl;
-        impl.log(type, level, file, line, source, message);
+        impl().log(type, level, file, line, source, std::move(message));
     }
+
+    void LoggerManager::flush() noexcept { impl().flush(); }
+
+    namespace
+    {
+        /// Буферы бинарных записей потока по глубине вложенности; unique_ptr сохраняет адреса при росте вектора
+        struct BinaryBuffers {
+            std::vector<std::unique_ptr<std::string>> buffers;
+            size_t depth = 0;
+        };
+        thread_local BinaryBuffers binary_buffers;
+    }
+
+    std::string &LoggerManager::acquireBinaryBuffer() noexcept
+    {
+        auto &[buffers, depth] = binary_buffers;
+        if (depth == buffers.size()) buffers.push_back(std::make_unique<std::string>());
+        return *buffers[depth++];
+    }
+
+    void LoggerManager::releaseBinaryBuffer() noexcept { binary_buffers.depth--; }
+
+    void LoggerManager::commitBinary(CallSite &site, std::string &record) noexcept { impl().commit(site, record); }
 }
@@ -1,50 +1,113 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <type_traits>
 
 #ifndef LOG_NAME
 #define LOG_NAME "UNKNOWN_SOURCE"
 #endif
 
+/// Порог уровня на этапе компиляции: вызовы с уровнем выше порога вырезаются компилятором целиком.
+/// Например, -DLOG_MIN_LEVEL_GREEN=1 оставит в сборке только G_LOG(0, ...) и G_LOG(1, ...)
+#ifndef LOG_MIN_LEVEL_WHITE
+#define LOG_MIN_LEVEL_WHITE 0xFFFF
+#endif
+#ifndef LOG_MIN_LEVEL_RED
+#define LOG_MIN_LEVEL_RED 0xFFFF
+#endif
+#ifndef LOG_MIN_LEVEL_GREEN
+#define LOG_MIN_LEVEL_GREEN 0xFFFF
+#endif
+#ifndef LOG_MIN_LEVEL_YELLOW
+#define LOG_MIN_LEVEL_YELLOW 0xFFFF
+#endif
+
+/// Запись сообщения: бинарная или текстовая. Используется внутри do {} while (0) после проверок уровня
+#define LOG_WRITE(TYPE, LEVEL, STREAM)                                                                                 \
+    if (d3156::LoggerManager::binary.load(std::memory_order_relaxed)) {                                                \
+        static d3156::LoggerManager::CallSite log_site_{__FILE__, __LINE__, LOG_NAME, TYPE};                           \
+        d3156::LoggerManager::BinaryRecord log_record_(log_site_, LEVEL);                                              \
+        log_record_ << STREAM;                                                                                         \
+        break;                                                                                                         \
+    }                                                                                                                  \
+    std::ostringstream oss;                                                                                            \
+    oss << STREAM;                                                                                                     \
+    d3156::LoggerManager::log(TYPE, LEVEL, __FILE__, __LINE__, LOG_NAME, oss.str());
+
 #define LOG_IMPL(TYPE, LEVEL, STREAM)                                                                                  \
     do {                                                                                                               \
-        if (!d3156::LoggerManager::allowed(TYPE, LEVEL)) break;                                                        \
-        std::ostringstream oss;                                                                                        \
-        oss << STREAM;                                                                                                 \
-        d3156::LoggerManager::log(TYPE, LEVEL, __FILE__, __LINE__, LOG_NAME, oss.str());                               \
+        if ((LEVEL) > d3156::LoggerManager::compiledLevel(TYPE)) break;                                                \
+        if (!d3156::LoggerManager::enabled(TYPE, LEVEL)) break;                                                        \
+        LOG_WRITE(TYPE, LEVEL, STREAM)                                                                                 \
     } while (0)
 
-#ifdef NO_LOG
-#define LOG(level, stream)                                                                                             \
+/// Ограничитель места вызова (LIMITER - EveryN или RateLimit, ARG - его параметр, вычисляется при первом вызове).
+/// Проверка идёт до сборки сообщения: отброшенная строка стоит одной атомарной операции
+#define LOG_LIMITED_IMPL(TYPE, LEVEL, LIMITER, ARG, STREAM)                                                            \
+    do {                                                                                                               \
+        if ((LEVEL) > d3156::LoggerManager::compiledLevel(TYPE)) break;                                                \
+        if (!d3156::LoggerManager::enabled(TYPE, LEVEL)) break;                                                        \
+        static d3156::LoggerManager::LIMITER log_limit_(ARG);                                                          \
+        if (!log_limit_.pass()) break;                                                                                 \
+        const d3156::LoggerManager::Suppressed log_suppressed_{log_limit_.takeSuppressed()};                           \
+        LOG_WRITE(TYPE, LEVEL, STREAM << log_suppressed_)                                                              \
+    } while (0)
+
+#define LOG_NOTHING                                                                                                    \
     do {                                                                                                               \
     } while (0)
+
+/// X_LOG_EVERY_N(level, n, ...) выводит каждый n-й вызов этого места, начиная с первого; X_LOG_RATE(level, per_second,
+/// ...) - не больше per_second сообщений в секунду с этого места (маркерное ведро с запасом на секунду). К выведенному
+/// сообщению дописывается число отброшенных с прошлого вывода
+#ifdef NO_LOG
+#define LOG(level, stream) LOG_NOTHING
+#define LOG_EVERY_N(level, n, stream) LOG_NOTHING
+#define LOG_RATE(level, per_second, stream) LOG_NOTHING
 #else
 #define LOG(level, stream) LOG_IMPL(d3156::LogType::WHITE, level, stream)
+#define LOG_EVERY_N(level, n, stream) LOG_LIMITED_IMPL(d3156::LogType::WHITE, level, EveryN, n, stream)
+#define LOG_RATE(level, per_second, stream)                                                                            \
+    LOG_LIMITED_IMPL(d3156::LogType::WHITE, level, RateLimit, per_second, stream)
 #endif
 
 #ifdef NO_GLOG
-#define G_LOG(level, stream)                                                                                           \
-    do {                                                                                                               \
-    } while (0)
+#define G_LOG(level, stream) LOG_NOTHING
+#define G_LOG_EVERY_N(level, n, stream) LOG_NOTHING
+#define G_LOG_RATE(level, per_second, stream) LOG_NOTHING
 #else
 #define G_LOG(level, stream) LOG_IMPL(d3156::LogType::GREEN, level, stream)
+#define G_LOG_EVERY_N(level, n, stream) LOG_LIMITED_IMPL(d3156::LogType::GREEN, level, EveryN, n, stream)
+#define G_LOG_RATE(level, per_second, stream)                                                                          \
+    LOG_LIMITED_IMPL(d3156::LogType::GREEN, level, RateLimit, per_second, stream)
 #endif
 
 #ifdef NO_YLOG
-#define Y_LOG(level, stream)                                                                                           \
-    do {                                                                                                               \
-    } while (0)
+#define Y_LOG(level, stream) LOG_NOTHING
+#define Y_LOG_EVERY_N(level, n, stream) LOG_NOTHING
+#define Y_LOG_RATE(level, per_second, stream) LOG_NOTHING
 #else
 #define Y_LOG(level, stream) LOG_IMPL(d3156::LogType::YELLOW, level, stream)
+#define Y_LOG_EVERY_N(level, n, stream) LOG_LIMITED_IMPL(d3156::LogType::YELLOW, level, EveryN, n, stream)
+#define Y_LOG_RATE(level, per_second, stream)                                                                          \
+    LOG_LIMITED_IMPL(d3156::LogType::YELLOW, level, RateLimit, per_second, stream)
 #endif
 
 #ifdef NO_RLOG
-#define R_LOG(level, stream)                                                                                           \
-    do {                                                                                                               \
-    } while (0)
+#define R_LOG(level, stream) LOG_NOTHING
+#define R_LOG_EVERY_N(level, n, stream) LOG_NOTHING
+#define R_LOG_RATE(level, per_second, stream) LOG_NOTHING
 #else
 #define R_LOG(level, stream) LOG_IMPL(d3156::LogType::RED, level, stream)
+#define R_LOG_EVERY_N(level, n, stream) LOG_LIMITED_IMPL(d3156::LogType::RED, level, EveryN, n, stream)
+#define R_LOG_RATE(level, per_second, stream)                                                                          \
+    LOG_LIMITED_IMPL(d3156::LogType::RED, level, RateLimit, per_second, stream)
 #endif
 
 namespace d3156
@@ -52,9 +115,207 @@ namespace d3156
     enum class LogType : uint8_t { WHITE, RED, GREEN, YELLOW };
     namespace LoggerManager
     {
+        /// \brief Уровни всех типов, упакованные в одно слово: 16 бит на тип, смещение 16 * LogType
+        extern std::atomic<uint64_t> levels;
+
+        constexpr int compiledLevel(const LogType type)
+        {
+            switch (type) {
+                case LogType::WHITE: return LOG_MIN_LEVEL_WHITE;
+                case LogType::RED: return LOG_MIN_LEVEL_RED;
+                case LogType::GREEN: return LOG_MIN_LEVEL_GREEN;
+                case LogType::YELLOW: return LOG_MIN_LEVEL_YELLOW;
+            }
+            return 0;
+        }
+
+        /// \brief Встраиваемая проверка уровня: одно relaxed-чтение без вызова через PLT
+        inline bool enabled(const LogType type, const int level) noexcept
+        {
+            const uint64_t word = levels.load(std::memory_order_relaxed);
+            return level <= static_cast<int>((word >> (16 * static_cast<unsigned>(type))) & 0xFFFF);
+        }
+
+        /// \brief Включён бинарный вывод (OUT=BINARY)
+        extern std::atomic<bool> binary;
+
         void log(LogType type, int level, const char *file, int line, const char *source,
                  std::string &&message) noexcept;
         bool allowed(LogType type, int level) noexcept;
+        /// \brief Изменить уровень логирования типа во время работы
+        void setLevel(LogType type, uint16_t level) noexcept;
+        /// \brief Дождаться записи всех сообщений, накопленных в асинхронном режиме (LOG_MODE=ASYNC)
+        void flush() noexcept;
+
+        /// \brief Статическое описание места вызова для бинарного формата. Регистрируется в сегменте один раз,
+        /// далее записи ссылаются на него по id
+        struct CallSite {
+            const char *file;
+            int line;
+            const char *source;
+            LogType type;
+            std::atomic<uint32_t> id{0};
+
+            constexpr CallSite(const char *f, const int l, const char *s, const LogType t)
+                : file(f), line(l), source(s), type(t)
+            {
+            }
+        };
+
+        /// \brief Число сообщений, отброшенных ограничителем; выводится как " [N suppressed]", 0 - ничего
+        struct Suppressed {
+            uint64_t count;
+        };
+
+        inline std::ostream &operator<<(std::ostream &out, const Suppressed suppressed)
+        {
+            if (suppressed.count) out << " [" << suppressed.count << " suppressed]";
+            return out;
+        }
+
+        /// \brief Выборка 1 из n для места вызова (X_LOG_EVERY_N)
+        class EveryN
+        {
+        public:
+            explicit EveryN(const uint64_t n) noexcept : n_(n ? n : 1) {}
+
+            bool pass() noexcept
+            {
+                if (calls_.fetch_add(1, std::memory_order_relaxed) % n_ == 0) return true;
+                suppressed_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            uint64_t takeSuppressed() noexcept { return suppressed_.exchange(0, std::memory_order_relaxed); }
+
+        private:
+            const uint64_t n_;
+            std::atomic<uint64_t> calls_{0};
+            std::atomic<uint64_t> suppressed_{0};
+        };
+
+        /// \brief Маркерное ведро места вызова (X_LOG_RATE) в виде GCRA: одно атомарное время вместо счётчика и
+        /// отметки пополнения. Ёмкость - per_second маркеров (не меньше одного), per_second <= 0 отбрасывает всё
+        class RateLimit
+        {
+        public:
+            explicit RateLimit(const double per_second) noexcept
+                : interval_(per_second > 0 ? static_cast<int64_t>(1e9 / per_second) : 0),
+                  tolerance_(interval_ * (std::max<int64_t>(static_cast<int64_t>(per_second), 1) - 1))
+            {
+            }
+
+            bool pass() noexcept
+            {
+                if (interval_ > 0) {
+                    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                            std::chrono::steady_clock::now().time_since_epoch())
+                                            .count();
+                    int64_t tat = tat_.load(std::memory_order_relaxed);
+                    for (;;) {
+                        const int64_t base = std::max(tat, now);
+                        if (base - now > tolerance_) break;
+                        if (tat_.compare_exchange_weak(tat, base + interval_, std::memory_order_relaxed)) return true;
+                    }
+                }
+                suppressed_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            uint64_t takeSuppressed() noexcept { return suppressed_.exchange(0, std::memory_order_relaxed); }
+
+        private:
+            const int64_t interval_;  ///< нс на один маркер
+            const int64_t tolerance_; ///< Допустимое опережение расписания - запас ведра
+            std::atomic<int64_t> tat_{0};
+            std::atomic<uint64_t> suppressed_{0};
+        };
+
+        /// \brief Тег типа аргумента в бинарной записи
+        enum class ArgType : uint8_t { I64 = 1, U64, F64, BOOL, CHAR, STR, PTR };
+
+        /// \brief Размер заголовка бинарной записи: size(u32) site(u32) time_ns(u64) level(i32)
+        constexpr size_t binary_header_size = 20;
+
+        /// \brief Взять буфер текущего потока для сборки бинарной записи
+        /// \details Буферы образуют стек по глубине вложенности: если аргумент записи сам пишет в лог, вложенная
+        /// запись собирается в следующем буфере и не портит внешнюю. Каждый acquire завершается releaseBinaryBuffer
+        std::string &acquireBinaryBuffer() noexcept;
+        void releaseBinaryBuffer() noexcept;
+
+        /// \brief Дописать собранную запись в сегмент, при первом вызове зарегистрировав место вызова
+        void commitBinary(CallSite &site, std::string &record) noexcept;
+
+        /// \brief Запись в бинарном формате: аргументы потока сохраняются как есть, без форматирования
+        /// \note Манипуляторы потока (std::hex и т.п.) в бинарном формате игнорируются
+        class BinaryRecord
+        {
+        public:
+            BinaryRecord(CallSite &site, const int level) noexcept : site_(site), buf_(acquireBinaryBuffer())
+            {
+                buf_.assign(binary_header_size, '\0');
+                std::memcpy(buf_.data() + 16, &level, sizeof(level));
+            }
+
+            ~BinaryRecord()
+            {
+                commitBinary(site_, buf_);
+                releaseBinaryBuffer();
+            }
+
+            BinaryRecord(const BinaryRecord &)            = delete;
+            BinaryRecord &operator=(const BinaryRecord &) = delete;
+
+            BinaryRecord &operator<<(const char *str) { return str ? putString(str, std::strlen(str)) : *this; }
+            BinaryRecord &operator<<(const std::string &str) { return putString(str.data(), str.size()); }
+            BinaryRecord &operator<<(const std::string_view str) { return putString(str.data(), str.size()); }
+            BinaryRecord &operator<<(const void *ptr) { return put(ArgType::PTR, reinterpret_cast<uintptr_t>(ptr)); }
+            BinaryRecord &operator<<(std::ostream &(*)(std::ostream &)) { return *this; }
+            BinaryRecord &operator<<(std::ios_base &(*)(std::ios_base &)) { return *this; }
+            BinaryRecord &operator<<(const Suppressed suppressed)
+            {
+                return suppressed.count ? *this << " [" << suppressed.count << " suppressed]" : *this;
+            }
+
+            template <class T> BinaryRecord &operator<<(const T &value)
+            {
+                if constexpr (std::is_same_v<T, bool>)
+                    return put(ArgType::BOOL, static_cast<uint8_t>(value));
+                else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> ||
+                                   std::is_same_v<T, unsigned char>)
+                    return put(ArgType::CHAR, static_cast<char>(value));
+                else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+                    return put(ArgType::I64, static_cast<int64_t>(value));
+                else if constexpr (std::is_integral_v<T>)
+                    return put(ArgType::U64, static_cast<uint64_t>(value));
+                else if constexpr (std::is_floating_point_v<T>)
+                    return put(ArgType::F64, static_cast<double>(value));
+                else {
+                    std::ostringstream oss;
+                    oss << value;
+                    return *this << oss.str();
+                }
+            }
+
+        private:
+            template <class V> BinaryRecord &put(const ArgType type, const V value)
+            {
+                buf_.push_back(static_cast<char>(type));
+                buf_.append(reinterpret_cast<const char *>(&value), sizeof(value));
+                return *this;
+            }
+
+            BinaryRecord &putString(const char *data, const size_t size)
+            {
+                const auto len = static_cast<uint32_t>(size);
+                put(ArgType::STR, len);
+                buf_.append(data, len);
+                return *this;
+            }
+
+            CallSite &site_;
+            std::string &buf_;
+        };
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "Segment.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace d3156
+{
+    namespace
+    {
+        /// \brief Выделить блоки файла под [from, to), чтобы запись в отображение не упиралась в нехватку места
+        /// \return 0 или код ошибки (ENOSPC - диск заполнен)
+        int allocate(const int fd, const size_t from, const size_t to)
+        {
+            if (to <= from) return 0;
+            const int rc = posix_fallocate(fd, static_cast<off_t>(from), static_cast<off_t>(to - from));
+            if (rc != EINVAL && rc != EOPNOTSUPP) return rc;
+            /// Файловая система без fallocate: блоки выделяются записью нулей
+            static const char zeros[4096] = {};
+            for (size_t pos = from; pos < to;) {
+                const ssize_t n = pwrite(fd, zeros, std::min(sizeof(zeros), to - pos), static_cast<off_t>(pos));
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return n < 0 ? errno : ENOSPC;
+                pos += static_cast<size_t>(n);
+            }
+            return 0;
+        }
+
+        /// \brief Размер записанных данных файла: отбрасывает нулевой хвост, оставшийся после аварийного завершения
+        /// \details Сегмент выделяется на всю ёмкость и обрезается только в деструкторе, поэтому после падения или
+        /// kill файл остаётся полного размера с нулями после последней записи
+        size_t writtenSize(const int fd, size_t size)
+        {
+            char block[65536];
+            while (size > 0) {
+                const size_t len = std::min(sizeof(block), size);
+                const ssize_t n  = pread(fd, block, len, static_cast<off_t>(size - len));
+                if (n < 0 && errno == EINTR) continue;
+                if (n != static_cast<ssize_t>(len)) break;
+                for (size_t i = len; i > 0; --i)
+                    if (block[i - 1] != '\0') return size - len + i;
+                size -= len;
+            }
+            return size;
+        }
+    }
+
+    std::unique_ptr<MappedSegment> MappedSegment::create(const std::string &path, size_t capacity, const bool append)
+    {
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | (append ? 0 : O_TRUNC), 0644);
+        if (fd < 0) return nullptr;
+        size_t offset = 0;
+        struct stat st{};
+        if (append && fstat(fd, &st) == 0) {
+            offset   = writtenSize(fd, static_cast<size_t>(st.st_size));
+            capacity = std::max(capacity, offset);
+            if (offset != static_cast<size_t>(st.st_size) && ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+                // Нулевой хвост будет перезаписан новыми строками
+            }
+        }
+        /// ftruncate дал бы разреженный файл: при заполненном диске запись в отображение завершилась бы SIGBUS
+        if (const int rc = allocate(fd, offset, capacity); rc != 0) {
+            if (ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+                // Файл останется с частично выделенным хвостом
+            }
+            ::close(fd);
+            errno = rc;
+            return nullptr;
+        }
+        void *data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            return nullptr;
+        }
+        return std::unique_ptr<MappedSegment>(
+            new MappedSegment(path, fd, static_cast<char *>(data), capacity, offset));
+    }
+
+    MappedSegment::MappedSegment(std::string path, const int fd, char *data, const size_t capacity,
+                                 const size_t offset)
+        : path_(std::move(path)), fd_(fd), data_(data), capacity_(capacity), offset_(offset)
+    {
+    }
+
+    MappedSegment::~MappedSegment()
+    {
+        const size_t size = used();
+        munmap(data_, capacity_);
+        if (ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+            // Файл останется полного размера, хвост заполнен нулями
+        }
+        ::close(fd_);
+    }
+
+    char *MappedSegment::reserve(const size_t size) noexcept
+    {
+        size_t offset = offset_.load(std::memory_order_relaxed);
+        do {
+            if (offset + size > capacity_) return nullptr;
+        } while (!offset_.compare_exchange_weak(offset, offset + size, std::memory_order_relaxed));
+        return data_ + offset;
+    }
+
+    size_t MappedSegment::used() const noexcept
+    {
+        return offset_.load(std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace d3156
+{
+    /// \brief Файл фиксированной ёмкости, отображённый в память, с атомарным резервированием места под запись
+    /// \details Место на диске под всю ёмкость выделяется в create() (posix_fallocate), поэтому заполненный диск
+    /// приводит к ошибке при открытии сегмента, а не к SIGBUS при записи. Пока сегмент открыт, файл имеет полный
+    /// размер с нулевым хвостом; при закрытии и ротации он обрезается до записанного
+    class MappedSegment
+    {
+    public:
+        /// \param append Сохранить содержимое существующего файла и продолжить запись после него. Нулевой хвост
+        /// файла, не обрезанного из-за аварийного завершения, отбрасывается: режим предназначен для текста без NUL
+        /// \return nullptr, если файл не удалось создать, выделить под него место или отобразить (причина в errno)
+        static std::unique_ptr<MappedSegment> create(const std::string &path, size_t capacity, bool append = false);
+
+        /// \brief Обрезает файл до фактически записанного размера
+        ~MappedSegment();
+
+        MappedSegment(const MappedSegment &)            = delete;
+        MappedSegment &operator=(const MappedSegment &) = delete;
+
+        /// \brief Зарезервировать size байт. Потокобезопасно.
+        /// \return nullptr, если в сегменте не осталось места
+        char *reserve(size_t size) noexcept;
+
+        size_t used() const noexcept;
+        size_t capacity() const noexcept { return capacity_; }
+        const std::string &path() const noexcept { return path_; }
+
+    private:
+        MappedSegment(std::string path, int fd, char *data, size_t capacity, size_t offset);
+
+        std::string path_;
+        int fd_;
+        char *data_;
+        size_t capacity_;
+        std::atomic<size_t> offset_{0};
+    };
+}
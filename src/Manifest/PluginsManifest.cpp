@@ -0,0 +1,204 @@
+#include "PluginsManifest.hpp"
+#include "Logger/Log.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace d3156::PluginCore
+{
+    namespace
+    {
+#ifdef DEBUG
+        constexpr std::string_view plugin_suffix = ".Debug.so";
+#else
+        constexpr std::string_view plugin_suffix = ".so";
+#endif
+        constexpr std::string_view plugin_prefix = "lib";
+        constexpr std::string_view header        = "PluginCore-manifest\t1";
+
+        int64_t mtimeNs(const struct stat &st)
+        {
+            return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        }
+
+        std::optional<DirStamp> stampDir(const std::string &path)
+        {
+            struct stat st{};
+            if (stat(path.c_str(), &st) != 0) return std::nullopt;
+            return DirStamp{path, static_cast<uint64_t>(st.st_ino), mtimeNs(st)};
+        }
+
+        std::vector<std::string> split(const std::string &line)
+        {
+            std::vector<std::string> out;
+            size_t start = 0;
+            for (size_t end; (end = line.find('\t', start)) != std::string::npos; start = end + 1)
+                out.push_back(line.substr(start, end - start));
+            out.push_back(line.substr(start));
+            return out;
+        }
+    }
+
+    std::optional<std::string> pluginName(const std::string &file)
+    {
+        if (file.size() <= plugin_prefix.size() + plugin_suffix.size()) return std::nullopt;
+        if (!file.starts_with(plugin_prefix) || !file.ends_with(plugin_suffix)) return std::nullopt;
+        std::string name = file.substr(plugin_prefix.size(), file.size() - plugin_prefix.size() - plugin_suffix.size());
+        if (name.find('.') != std::string::npos) return std::nullopt;
+        return name;
+    }
+
+    std::optional<PluginSidecar> readSidecar(const std::string &library_path)
+    {
+        const fs::path path = fs::path(library_path).replace_extension(".plugin");
+        std::ifstream in(path);
+        if (!in) return std::nullopt;
+        PluginSidecar out;
+        std::string line;
+        for (size_t number = 1; std::getline(in, line); ++number) {
+            std::istringstream words(line);
+            std::string kind, value, extra;
+            if (!(words >> kind) || kind[0] == '#') continue;
+            if ((kind != "model" && kind != "arg") || !(words >> value) || (words >> extra && extra[0] != '#')) {
+                R_LOG(0, "Plugin description " << path << ":" << number << " is invalid, plugin is loaded eagerly");
+                return std::nullopt;
+            }
+            (kind == "model" ? out.models : out.args).push_back(value);
+        }
+        return out;
+    }
+
+    ScanResult scanPluginsDir(const fs::path &root)
+    {
+        ScanResult out;
+        if (auto stamp = stampDir(root.string())) out.dirs.push_back(*stamp);
+        for (const auto &de : fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied)) {
+            std::error_code ec;
+            if (de.is_directory(ec)) {
+                if (auto stamp = stampDir(de.path().string())) out.dirs.push_back(*stamp);
+                continue;
+            }
+            if (!de.is_regular_file(ec)) continue;
+            auto name = pluginName(de.path().filename().string());
+            if (!name) continue;
+            struct stat st{};
+            if (stat(de.path().c_str(), &st) != 0) continue;
+            out.plugins.push_back(
+                {std::move(*name), de.path().string(), static_cast<uint64_t>(st.st_size), mtimeNs(st), {}});
+        }
+        return out;
+    }
+
+    std::string PluginsManifest::pathFromEnv()
+    {
+        if (const char *val = std::getenv("PLUGINS_MANIFEST")) return val;
+        return "./.plugins.manifest";
+    }
+
+    bool PluginsManifest::load(const std::string &file)
+    {
+        std::ifstream in(file);
+        if (!in) return false;
+        std::string line;
+        if (!std::getline(in, line) || line != std::string(header) + "\t" + std::string(plugin_suffix)) {
+            Y_LOG(0, "Plugins manifest " << file << " has another format, ignored");
+            return false;
+        }
+        ScanResult *current = nullptr;
+        try {
+            while (std::getline(in, line)) {
+                const auto fields = split(line);
+                if (fields[0] == "root" && fields.size() == 2)
+                    current = &roots_[fields[1]];
+                else if (fields[0] == "dir" && fields.size() == 4 && current)
+                    current->dirs.push_back({fields[3], std::stoull(fields[1]), std::stoll(fields[2])});
+                else if (fields[0] == "plugin" && fields.size() == 6 && current)
+                    current->plugins.push_back(
+                        {fields[1], fields[5], std::stoull(fields[2]), std::stoll(fields[3]), fields[4]});
+                else
+                    throw std::invalid_argument(line);
+            }
+        } catch (const std::exception &) {
+            Y_LOG(0, "Plugins manifest " << file << " is corrupted, ignored");
+            roots_.clear();
+            return false;
+        }
+        return true;
+    }
+
+    bool PluginsManifest::save(const std::string &file) const
+    {
+        const std::string tmp = file + ".tmp." + std::to_string(getpid());
+        {
+            std::ofstream out(tmp, std::ios::trunc);
+            if (!out) {
+                Y_LOG(0, "Cannot write plugins manifest " << file);
+                return false;
+            }
+            out << header << '\t' << plugin_suffix << '\n';
+            for (const auto &[root, result] : roots_) {
+                out << "root\t" << root << '\n';
+                for (const auto &dir : result.dirs)
+                    out << "dir\t" << dir.inode << '\t' << dir.mtime_ns << '\t' << dir.path << '\n';
+                for (const auto &p : result.plugins)
+                    out << "plugin\t" << p.name << '\t' << p.size << '\t' << p.mtime_ns << '\t' << p.full_name << '\t'
+                        << p.path << '\n';
+            }
+            if (!out.flush()) {
+                Y_LOG(0, "Cannot write plugins manifest " << file);
+                fs::remove(tmp);
+                return false;
+            }
+        }
+        std::error_code ec;
+        fs::rename(tmp, file, ec);
+        if (ec) {
+            Y_LOG(0, "Cannot write plugins manifest " << file << ": " << ec.message());
+            fs::remove(tmp, ec);
+            return false;
+        }
+        return true;
+    }
+
+    std::optional<std::vector<PluginEntry>> PluginsManifest::lookup(const std::string &root) const
+    {
+        const auto it = roots_.find(root);
+        if (it == roots_.end() || it->second.dirs.empty()) return std::nullopt;
+        for (const auto &dir : it->second.dirs) {
+            const auto stamp = stampDir(dir.path);
+            if (!stamp || stamp->inode != dir.inode || stamp->mtime_ns != dir.mtime_ns) return std::nullopt;
+        }
+        for (const auto &plugin : it->second.plugins) {
+            struct stat st{};
+            if (stat(plugin.path.c_str(), &st) != 0) return std::nullopt;
+            if (static_cast<uint64_t>(st.st_size) != plugin.size || mtimeNs(st) != plugin.mtime_ns) return std::nullopt;
+        }
+        return it->second.plugins;
+    }
+
+    void PluginsManifest::update(const std::string &root, ScanResult result)
+    {
+        /// FULL_NAME известен только после загрузки: сохраняем его для неизменившихся библиотек
+        if (const auto it = roots_.find(root); it != roots_.end())
+            for (auto &plugin : result.plugins)
+                for (const auto &old : it->second.plugins)
+                    if (old.path == plugin.path && old.size == plugin.size && old.mtime_ns == plugin.mtime_ns)
+                        plugin.full_name = old.full_name;
+        roots_[root] = std::move(result);
+        dirty_       = true;
+    }
+
+    void PluginsManifest::setFullName(const std::string &path, const std::string &full_name)
+    {
+        for (auto &[root, result] : roots_)
+            for (auto &plugin : result.plugins)
+                if (plugin.path == path && plugin.full_name != full_name) {
+                    plugin.full_name = full_name;
+                    dirty_           = true;
+                }
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace d3156::PluginCore
+{
+    /// \brief Найденная библиотека плагина
+    struct PluginEntry {
+        std::string name;
+        std::string path;
+        uint64_t size     = 0;
+        int64_t mtime_ns  = 0;
+        std::string full_name; ///< FULL_NAME плагина (имя_версия:хэш сборки), если плагин его экспортирует
+    };
+
+    /// \brief Отметка каталога: по ней определяется, что содержимое каталога не менялось
+    struct DirStamp {
+        std::string path;
+        uint64_t inode   = 0;
+        int64_t mtime_ns = 0;
+    };
+
+    struct ScanResult {
+        std::vector<DirStamp> dirs;
+        std::vector<PluginEntry> plugins;
+    };
+
+    /// \brief Описание отложенного плагина из файла lib<Name>.plugin рядом с библиотекой
+    /// \details Строки "model <Имя модели без версии>" и "arg <длинное имя или однобуквенное короткое>", '#' -
+    /// комментарий. Плагин с таким файлом загружается, только когда запрошена одна из его моделей или в командной
+    /// строке есть один из его аргументов
+    struct PluginSidecar {
+        std::vector<std::string> models;
+        std::vector<std::string> args;
+    };
+
+    /// \return Описание для библиотеки library_path, nullopt - файла нет (плагин загружается сразу) или он ошибочен
+    std::optional<PluginSidecar> readSidecar(const std::string &library_path);
+
+    /// \brief Имя плагина по имени файла lib<Name>.so (lib<Name>.Debug.so при DEBUG), nullopt - файл не плагин
+    std::optional<std::string> pluginName(const std::string &file);
+
+    /// \brief Рекурсивно найти плагины в каталоге root и отметки всех его подкаталогов
+    ScanResult scanPluginsDir(const std::filesystem::path &root);
+
+    /// \brief Кэш найденных плагинов по каталогам PLUGINS_DIR
+    /// \details Для каждого каталога хранит inode и mtime его и всех подкаталогов, а также размер и mtime каждой
+    /// библиотеки. Если ничего из этого не изменилось, набор плагинов берётся из кэша без обхода каталогов.
+    /// Файл задаётся PLUGINS_MANIFEST (по умолчанию ./.plugins.manifest, пустое значение отключает кэш).
+    class PluginsManifest
+    {
+    public:
+        /// \return Путь к файлу кэша, пустой - кэш отключён
+        static std::string pathFromEnv();
+
+        /// \return false, если файла нет или он другого формата
+        bool load(const std::string &file);
+        bool save(const std::string &file) const;
+
+        /// \return Плагины каталога root из кэша, nullopt - кэша нет или каталог изменился
+        std::optional<std::vector<PluginEntry>> lookup(const std::string &root) const;
+        void update(const std::string &root, ScanResult result);
+        /// \brief Запомнить FULL_NAME загруженной библиотеки
+        void setFullName(const std::string &path, const std::string &full_name);
+
+        bool dirty() const { return dirty_; }
+
+    private:
+        std::map<std::string, ScanResult> roots_;
+        bool dirty_ = false;
+    };
+}
@@ -0,0 +1,110 @@
+#include "Memory.hpp"
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+
+namespace d3156::PluginCore
+{
+    namespace
+    {
+        bool poolArena()
+        {
+            const char *val = std::getenv("MEMORY_ARENA");
+            return val && std::strcmp(val, "pool") == 0;
+        }
+
+        std::string formatBytes(const int64_t bytes)
+        {
+            const char *units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+            double value        = static_cast<double>(bytes);
+            size_t unit         = 0;
+            while (std::abs(value) >= 1024 && unit + 1 < std::size(units)) {
+                value /= 1024;
+                ++unit;
+            }
+            std::ostringstream out;
+            out.precision(unit ? 1 : 0);
+            out << std::fixed << value << ' ' << units[unit];
+            return out.str();
+        }
+
+        void appendUsage(std::ostringstream &out, const TrackedResource::Usage &usage, const double seconds)
+        {
+            out << "live " << formatBytes(usage.live) << ", peak " << formatBytes(usage.peak) << ", "
+                << usage.allocations << " allocations ("
+                << (seconds > 0 ? static_cast<double>(usage.allocations) / seconds : 0) << "/s)";
+        }
+    }
+
+    std::string Memory::name() { return "Memory_" PLUGIN_CORE_VERSION ":PluginCore"; }
+
+    void Memory::init() { G_LOG(0, "Memory: " << (poolArena() ? "pool arena per plugin" : "shared heap")); }
+
+    TrackedResource *Memory::plugin(const std::string &name)
+    {
+        /// Перезагружаемая версия плагина (<Name>@reload) учитывается вместе с прежней
+        const std::string plugin = name.substr(0, name.find('@'));
+        std::lock_guard lock(mutex_);
+        auto &arena = plugins_[plugin];
+        if (!arena.resource) {
+            if (poolArena()) arena.pool = std::make_unique<std::pmr::synchronized_pool_resource>();
+            arena.resource = std::make_unique<TrackedResource>(
+                plugin, arena.pool ? arena.pool.get() : std::pmr::new_delete_resource());
+        }
+        return arena.resource.get();
+    }
+
+    std::shared_ptr<TrackedResource> Memory::model(const std::string &name, const std::string &plugin)
+    {
+        TrackedResource *upstream = this->plugin(plugin);
+        auto resource             = std::make_shared<TrackedResource>(name, upstream);
+        std::lock_guard lock(mutex_);
+        std::erase_if(models_, [](const auto &model) { return model.second.expired(); });
+        models_.emplace_back(upstream->name(), resource);
+        return resource;
+    }
+
+    std::vector<Memory::Line> Memory::plugins() const
+    {
+        std::lock_guard lock(mutex_);
+        std::vector<Line> out;
+        for (const auto &[name, arena] : plugins_) out.push_back({name, name, arena.resource->usage()});
+        return out;
+    }
+
+    std::vector<Memory::Line> Memory::models() const
+    {
+        std::lock_guard lock(mutex_);
+        std::vector<Line> out;
+        for (const auto &[plugin, model] : models_)
+            if (const auto resource = model.lock()) out.push_back({resource->name(), plugin, resource->usage()});
+        return out;
+    }
+
+    std::string Memory::report() const
+    {
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+        const auto models    = this->models();
+        std::ostringstream out;
+        out.precision(1);
+        out << std::fixed << "Memory of plugins and models:";
+        for (const auto &plugin : plugins()) {
+            out << "\n  Plugin " << plugin.name << ": ";
+            appendUsage(out, plugin.usage, seconds);
+            for (const auto &model : models)
+                if (model.plugin == plugin.name && model.usage.allocations != 0) {
+                    out << "\n    Model " << model.name << ": ";
+                    appendUsage(out, model.usage, seconds);
+                }
+        }
+        return out.str();
+    }
+
+    Memory::~Memory()
+    {
+        for (const auto &[name, arena] : plugins_)
+            if (const auto live = arena.resource->usage().live; live != 0)
+                Y_LOG(0, "Plugin " << name << " did not free " << formatBytes(live) << " of tracked memory");
+    }
+}
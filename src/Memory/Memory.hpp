@@ -0,0 +1,56 @@
+#pragma once
+#include "IModel.hpp"
+#include "TrackedResource.hpp"
+#include <chrono>
+#include <limits>
+#include <map>
+#include <mutex>
+
+namespace d3156::PluginCore
+{
+    /// \brief Учёт памяти плагинов и моделей, которым владеет Core
+    /// \details У каждого плагина свой TrackedResource, у каждой модели - свой поверх ресурса её плагина
+    /// (IModel::memory()). Учитываются выделения через эти ресурсы (std::pmr-контейнеры, allocate()), а не вся куча
+    /// процесса. MEMORY_ARENA=pool даёт каждому плагину отдельный пул (std::pmr::synchronized_pool_resource), и
+    /// потоки разных плагинов не делят блокировки аллокатора; по умолчанию выделения идут в общую кучу.
+    /// Сводка - report(), выводится в лог при завершении и раз в MEMORY_LOG_PERIOD_MS мс, если задано.
+    class Memory final : public IModel
+    {
+    public:
+        struct Line {
+            std::string name;
+            std::string plugin; ///< Для модели - плагин, создавший её
+            TrackedResource::Usage usage;
+        };
+
+        static std::string name();
+        /// Удаляется последней: ресурсы моделей ссылаются на ресурсы плагинов
+        int deleteOrder() override { return std::numeric_limits<int>::max(); }
+        void init() override;
+        ~Memory() override;
+
+        /// \brief Ресурс плагина (создаётся при первом запросе)
+        TrackedResource *plugin(const std::string &name);
+        std::vector<Line> plugins() const;
+        /// \return Модели, которые ещё существуют
+        std::vector<Line> models() const;
+        /// \brief Сводка: по плагинам и их моделям - текущий и пиковый объём, число выделений и их частота
+        /// \note Модели без выделений не выводятся
+        std::string report() const;
+
+    private:
+        friend class ModelsStorage;
+        /// \brief Ресурс новой модели поверх ресурса плагина plugin
+        std::shared_ptr<TrackedResource> model(const std::string &name, const std::string &plugin);
+
+        struct Arena {
+            std::unique_ptr<std::pmr::memory_resource> pool; ///< nullptr - общая куча
+            std::unique_ptr<TrackedResource> resource;
+        };
+
+        mutable std::mutex mutex_;
+        std::map<std::string, Arena> plugins_;
+        std::vector<std::pair<std::string, std::weak_ptr<TrackedResource>>> models_; ///< Плагин, ресурс
+        std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+    };
+}
@@ -0,0 +1,35 @@
+#include "TrackedResource.hpp"
+#include <utility>
+
+namespace d3156::PluginCore
+{
+    TrackedResource::TrackedResource(std::string name, std::pmr::memory_resource *upstream)
+        : name_(std::move(name)), upstream_(upstream)
+    {
+    }
+
+    void *TrackedResource::do_allocate(const size_t bytes, const size_t alignment)
+    {
+        void *p = upstream_->allocate(bytes, alignment);
+        allocations_.fetch_add(1, std::memory_order_relaxed);
+        bytes_.fetch_add(bytes, std::memory_order_relaxed);
+        const auto size    = static_cast<int64_t>(bytes);
+        const int64_t live = live_.fetch_add(size, std::memory_order_relaxed) + size;
+        int64_t peak       = peak_.load(std::memory_order_relaxed);
+        while (live > peak && !peak_.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+            ;
+        return p;
+    }
+
+    void TrackedResource::do_deallocate(void *p, const size_t bytes, const size_t alignment)
+    {
+        upstream_->deallocate(p, bytes, alignment);
+        live_.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+    }
+
+    TrackedResource::Usage TrackedResource::usage() const noexcept
+    {
+        return {live_.load(std::memory_order_relaxed), peak_.load(std::memory_order_relaxed),
+                allocations_.load(std::memory_order_relaxed), bytes_.load(std::memory_order_relaxed)};
+    }
+}
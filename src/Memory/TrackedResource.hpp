@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+
+namespace d3156::PluginCore
+{
+    /// \brief Ресурс памяти, считающий выделения: текущий и пиковый объём, число и суммарный объём выделений
+    /// \details Передаёт выделения ресурсу upstream. Ресурс модели ссылается на ресурс её плагина, поэтому выделения
+    /// модели учитываются и в плагине
+    class TrackedResource final : public std::pmr::memory_resource
+    {
+    public:
+        struct Usage {
+            int64_t live         = 0;
+            int64_t peak         = 0;
+            uint64_t allocations = 0;
+            uint64_t bytes       = 0; ///< Всего выделено за время жизни
+        };
+
+        TrackedResource(std::string name, std::pmr::memory_resource *upstream);
+
+        const std::string &name() const { return name_; }
+        Usage usage() const noexcept;
+
+    private:
+        void *do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+        std::string name_;
+        std::pmr::memory_resource *upstream_;
+        std::atomic<int64_t> live_{0};
+        std::atomic<int64_t> peak_{0};
+        std::atomic<uint64_t> allocations_{0};
+        std::atomic<uint64_t> bytes_{0};
+    };
+}
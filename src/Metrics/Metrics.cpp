@@ -0,0 +1,358 @@
+#include "Metrics.hpp"
+#include "EventLoop/EventLoop.hpp"
+#include "Utils/ParallelFor.hpp"
+#include "Utils/Watchdog.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace d3156::PluginCore
+{
+    namespace
+    {
+        /// Ячеек счётчика - не больше 64, гистограммы (около 4 КБ на ячейку) - не больше 8
+        constexpr size_t max_counter_shards   = 64;
+        constexpr size_t max_histogram_shards = 8;
+        /// Сколько ждать HTTP-запрос от клиента сокета, прежде чем ответить текстом
+        constexpr std::chrono::milliseconds request_wait(50);
+        /// Сколько ждать, пока медленный клиент примет ответ, прежде чем закрыть соединение
+        constexpr std::chrono::milliseconds send_wait(1000);
+
+        const char *typeName(const Metrics::Type type)
+        {
+            switch (type) {
+                case Metrics::Type::Counter: return "counter";
+                case Metrics::Type::Gauge: return "gauge";
+                case Metrics::Type::Histogram: return "histogram";
+            }
+            return "";
+        }
+
+        std::string number(const double value)
+        {
+            if (std::isinf(value)) return value > 0 ? "+Inf" : "-Inf";
+            if (std::isnan(value)) return "NaN";
+            char buffer[32];
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            return {buffer, result.ptr};
+        }
+
+        /// Имя метрики Prometheus: [a-zA-Z_:][a-zA-Z0-9_:]*
+        std::string metricName(const std::string &name)
+        {
+            std::string out = name;
+            for (size_t i = 0; i < out.size(); ++i) {
+                const char c = out[i];
+                if (!std::isalpha(static_cast<unsigned char>(c)) && c != '_' && c != ':' &&
+                    (i == 0 || !std::isdigit(static_cast<unsigned char>(c))))
+                    out[i] = '_';
+            }
+            return out.empty() ? "_" : out;
+        }
+
+        std::string escape(const std::string &value, const bool quotes)
+        {
+            std::string out;
+            for (const char c : value) {
+                if (c == '\\')
+                    out += "\\\\";
+                else if (c == '\n')
+                    out += "\\n";
+                else if (c == '"' && quotes)
+                    out += "\\\"";
+                else
+                    out += c;
+            }
+            return out;
+        }
+    }
+
+    std::string Metrics::name() { return "Metrics_" PLUGIN_CORE_VERSION ":PluginCore"; }
+
+    size_t Metrics::nextSlot() noexcept
+    {
+        static std::atomic<size_t> next{0};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Metrics::Counter::Counter(const size_t shards) : shards_(std::make_unique<Shard[]>(shards)), mask_(shards - 1) {}
+
+    uint64_t Metrics::Counter::value() const noexcept
+    {
+        uint64_t sum = 0;
+        for (size_t i = 0; i <= mask_; ++i) sum += shards_[i].value.load(std::memory_order_relaxed);
+        return sum;
+    }
+
+    Metrics::Histogram::Histogram(const size_t shards) : shards_(std::make_unique<Shard[]>(shards)), mask_(shards - 1)
+    {}
+
+    uint64_t Metrics::Histogram::upperBound(const size_t bucket) noexcept
+    {
+        if (bucket < (size_t(2) << sub_bits)) return bucket;
+        const unsigned shift  = (bucket >> sub_bits) - 1;
+        const uint64_t mantis = (bucket & ((size_t(1) << sub_bits) - 1)) + (uint64_t(1) << sub_bits);
+        /// Для последней корзины сдвиг выходит за 64 бита и даёт UINT64_MAX
+        return ((mantis + 1) << shift) - 1;
+    }
+
+    Metrics::HistogramSnapshot Metrics::Histogram::snapshot() const
+    {
+        HistogramSnapshot out;
+        std::array<uint64_t, bucket_count> counts{};
+        for (size_t i = 0; i <= mask_; ++i) {
+            const Shard &shard = shards_[i];
+            for (size_t b = 0; b < bucket_count; ++b) counts[b] += shard.buckets[b].load(std::memory_order_relaxed);
+            out.sum += shard.sum.load(std::memory_order_relaxed);
+        }
+        for (size_t b = 0; b < bucket_count; ++b) {
+            if (counts[b] == 0) continue;
+            out.buckets.emplace_back(upperBound(b), counts[b]);
+            out.count += counts[b];
+        }
+        return out;
+    }
+
+    uint64_t Metrics::HistogramSnapshot::quantile(const double q) const
+    {
+        if (count == 0) return 0;
+        const auto rank = std::clamp<uint64_t>(static_cast<uint64_t>(std::ceil(q * double(count))), 1, count);
+        uint64_t seen   = 0;
+        for (const auto &[upper, n] : buckets)
+            if ((seen += n) >= rank) return upper;
+        return buckets.back().first;
+    }
+
+    void Metrics::init()
+    {
+        std::lock_guard lock(mutex_);
+        counter_shards_   = std::bit_ceil(std::min(availableCpus(), max_counter_shards));
+        histogram_shards_ = std::min(counter_shards_, max_histogram_shards);
+        G_LOG(0, "Metrics: " << counter_shards_ << " counter shards, " << histogram_shards_ << " histogram shards");
+    }
+
+    void Metrics::postInit()
+    {
+        if (loop_ == nullptr) return;
+        if (const auto period = Watchdog::timeoutFromEnv("METRICS_LOG_PERIOD_MS", std::chrono::milliseconds(0));
+            period.count() > 0)
+            dump_timer_ = loop_->addTimer(period, [this] { dump(); }, period);
+        if (const char *val = std::getenv("METRICS_MAX_CLIENTS")) {
+            try {
+                max_clients_ = std::max<size_t>(std::stoul(val), 1);
+            } catch (...) {
+                Y_LOG(0, "Invalid METRICS_MAX_CLIENTS value " << val);
+            }
+        }
+        if (const char *path = std::getenv("METRICS_SOCKET"); path && *path) listen(path);
+    }
+
+    Metrics::~Metrics()
+    {
+        if (loop_) {
+            if (dump_timer_) loop_->cancelTimer(dump_timer_);
+            for (const auto &[client, state] : clients_) {
+                loop_->cancelTimer(state.timer);
+                loop_->removeFd(client);
+                close(client);
+            }
+            if (listen_fd_ >= 0) loop_->removeFd(listen_fd_);
+        }
+        if (listen_fd_ >= 0) {
+            close(listen_fd_);
+            unlink(socket_path_.c_str());
+        }
+    }
+
+    Metrics::Entry &Metrics::entry(const std::string &name, const std::string &help, const std::string_view owner,
+                                   const Type type)
+    {
+        std::lock_guard lock(mutex_);
+        auto [it, inserted] = entries_.try_emplace(name);
+        Entry *entry        = &it->second;
+        if (!inserted) {
+            if (entry->type == type) return *entry;
+            R_LOG(0, "Metric " << name << " of " << entry->owner << " is a " << typeName(entry->type) << ", " << owner
+                               << " requested a " << typeName(type) << "; the new metric is not exported");
+            entry = &detached_.emplace_back();
+        }
+        entry->help  = help;
+        entry->owner = owner;
+        entry->type  = type;
+        /// Метрики, созданные до init(), получают по одной ячейке
+        switch (type) {
+            case Type::Counter: entry->counter.reset(new Counter(counter_shards_)); break;
+            case Type::Gauge: entry->gauge.reset(new Gauge()); break;
+            case Type::Histogram: entry->histogram.reset(new Histogram(histogram_shards_)); break;
+        }
+        return *entry;
+    }
+
+    Metrics::Counter &Metrics::counter(const std::string &name, const std::string &help, const std::string_view owner)
+    {
+        return *entry(name, help, owner, Type::Counter).counter;
+    }
+
+    Metrics::Gauge &Metrics::gauge(const std::string &name, const std::string &help, const std::string_view owner)
+    {
+        return *entry(name, help, owner, Type::Gauge).gauge;
+    }
+
+    Metrics::Histogram &Metrics::histogram(const std::string &name, const std::string &help,
+                                           const std::string_view owner)
+    {
+        return *entry(name, help, owner, Type::Histogram).histogram;
+    }
+
+    std::vector<Metrics::MetricSnapshot> Metrics::snapshot() const
+    {
+        std::lock_guard lock(mutex_);
+        std::vector<MetricSnapshot> out;
+        out.reserve(entries_.size());
+        for (const auto &[name, entry] : entries_) {
+            MetricSnapshot metric{name, entry.help, entry.owner, entry.type, 0, {}};
+            switch (entry.type) {
+                case Type::Counter: metric.value = double(entry.counter->value()); break;
+                case Type::Gauge: metric.value = entry.gauge->value(); break;
+                case Type::Histogram: metric.histogram = entry.histogram->snapshot(); break;
+            }
+            out.push_back(std::move(metric));
+        }
+        return out;
+    }
+
+    std::string Metrics::prometheus() const
+    {
+        std::string out;
+        for (const auto &metric : snapshot()) {
+            const std::string name  = metricName(metric.name);
+            const std::string label = "plugin=\"" + escape(metric.owner, true) + "\"";
+            if (!metric.help.empty()) out += "# HELP " + name + " " + escape(metric.help, false) + "\n";
+            out += "# TYPE " + name + " " + typeName(metric.type) + "\n";
+            if (metric.type != Type::Histogram) {
+                out += name + "{" + label + "} " + number(metric.value) + "\n";
+                continue;
+            }
+            /// Выводятся только непустые корзины: границы le совпадают с границами лог-линейной шкалы
+            uint64_t cumulative = 0;
+            for (const auto &[upper, count] : metric.histogram.buckets) {
+                cumulative += count;
+                out += name + "_bucket{" + label + ",le=\"" + std::to_string(upper) + "\"} " +
+                       std::to_string(cumulative) + "\n";
+            }
+            out += name + "_bucket{" + label + ",le=\"+Inf\"} " + std::to_string(metric.histogram.count) + "\n";
+            out += name + "_sum{" + label + "} " + std::to_string(metric.histogram.sum) + "\n";
+            out += name + "_count{" + label + "} " + std::to_string(metric.histogram.count) + "\n";
+        }
+        return out;
+    }
+
+    void Metrics::dump() const
+    {
+        for (const auto &metric : snapshot()) {
+            if (metric.type != Type::Histogram) {
+                G_LOG(0, "Metrics [" << metric.owner << "] " << metric.name << " = " << number(metric.value));
+                continue;
+            }
+            const auto &h = metric.histogram;
+            G_LOG(0, "Metrics [" << metric.owner << "] " << metric.name << ": count " << h.count << ", p50 "
+                                 << h.quantile(0.5) << ", p90 " << h.quantile(0.9) << ", p99 " << h.quantile(0.99)
+                                 << ", max " << h.quantile(1));
+        }
+    }
+
+    void Metrics::listen(const std::string &path)
+    {
+        sockaddr_un addr{};
+        if (path.size() >= sizeof(addr.sun_path)) {
+            R_LOG(0, "Metrics: socket path " << path << " is too long");
+            return;
+        }
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        unlink(path.c_str());
+        if (listen_fd_ < 0 || bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+            ::listen(listen_fd_, 16) < 0) {
+            R_LOG(0, "Metrics: cannot listen on " << path << ": " << std::strerror(errno));
+            if (listen_fd_ >= 0) close(listen_fd_);
+            listen_fd_ = -1;
+            return;
+        }
+        socket_path_ = path;
+        loop_->addFd(listen_fd_, EPOLLIN, [this](uint32_t) {
+            int client;
+            while ((client = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                if (clients_.size() >= max_clients_) {
+                    Y_LOG_RATE(0, 1, "Metrics: " << clients_.size() << " clients already connected, connection closed");
+                    close(client);
+                    continue;
+                }
+                /// Клиент без запроса (socat, nc) получает метрики текстом по истечении ожидания
+                clients_[client].timer = loop_->addTimer(request_wait, [this, client] { serve(client, false); });
+                loop_->addFd(client, EPOLLIN, [this, client](uint32_t) {
+                    char request[1024];
+                    const ssize_t size = recv(client, request, sizeof(request), 0);
+                    serve(client, size >= 4 && std::memcmp(request, "GET ", 4) == 0);
+                });
+            }
+        });
+        G_LOG(0, "Metrics: serving Prometheus text on " << path << ", at most " << max_clients_ << " clients");
+    }
+
+    void Metrics::serve(const int client, const bool http)
+    {
+        const auto it = clients_.find(client);
+        if (it == clients_.end() || !it->second.response.empty()) return;
+        loop_->cancelTimer(it->second.timer);
+        loop_->removeFd(client);
+
+        std::string response = prometheus();
+        if (http)
+            response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                       std::to_string(response.size()) + "\r\nConnection: close\r\n\r\n" + response;
+        it->second.response = std::move(response);
+        it->second.timer    = loop_->addTimer(send_wait, [this, client] { disconnect(client); });
+        sendResponse(client);
+        /// Сокет не блокируется: остаток ответа отправляется по готовности, цикл не ждёт медленного клиента
+        if (clients_.contains(client))
+            loop_->addFd(client, EPOLLOUT, [this, client](const uint32_t events) {
+                if (events & (EPOLLERR | EPOLLHUP))
+                    disconnect(client);
+                else
+                    sendResponse(client);
+            });
+    }
+
+    void Metrics::sendResponse(const int client)
+    {
+        const auto it = clients_.find(client);
+        if (it == clients_.end()) return;
+        Client &state = it->second;
+        while (state.sent < state.response.size()) {
+            const ssize_t n =
+                send(client, state.response.data() + state.sent, state.response.size() - state.sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+            if (n <= 0) break;
+            state.sent += static_cast<size_t>(n);
+        }
+        disconnect(client);
+    }
+
+    void Metrics::disconnect(const int client)
+    {
+        const auto it = clients_.find(client);
+        if (it == clients_.end()) return;
+        loop_->cancelTimer(it->second.timer);
+        loop_->removeFd(client);
+        close(client);
+        clients_.erase(it);
+    }
+}
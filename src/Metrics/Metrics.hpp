@@ -0,0 +1,190 @@
+#pragma once
+#include "IModel.hpp"
+#include <atomic>
+#include <bit>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string_view>
+
+namespace d3156::PluginCore
+{
+    class EventLoop;
+
+    /// \brief Реестр метрик (счётчики, датчики, гистограммы), которым владеет Core
+    /// \details Плагины получают его через models.registerModel<Metrics>(). Обновление метрики - одна атомарная
+    /// операция без блокировок над ячейкой потока (счётчики и гистограммы разбиты на ячейки по потокам), сложение
+    /// ячеек выполняется только при чтении. Экспорт:
+    /// - snapshot() и prometheus() - по запросу;
+    /// - METRICS_LOG_PERIOD_MS=N - вывод всех метрик в лог раз в N мс;
+    /// - METRICS_SOCKET=path - Unix-сокет, отдающий метрики в текстовом формате Prometheus (на HTTP-запрос GET -
+    ///   HTTP-ответом, иначе - сразу текстом).
+    class Metrics final : public IModel
+    {
+    public:
+        enum class Type { Counter, Gauge, Histogram };
+
+        /// \brief Монотонный счётчик
+        class Counter
+        {
+        public:
+            void add(const uint64_t n = 1) noexcept
+            {
+                shards_[threadSlot() & mask_].value.fetch_add(n, std::memory_order_relaxed);
+            }
+            uint64_t value() const noexcept;
+
+        private:
+            friend class Metrics;
+            explicit Counter(size_t shards);
+
+            struct alignas(64) Shard {
+                std::atomic<uint64_t> value{0};
+            };
+            std::unique_ptr<Shard[]> shards_;
+            size_t mask_;
+        };
+
+        /// \brief Текущее значение (размер очереди, число соединений)
+        class Gauge
+        {
+        public:
+            void set(const double value) noexcept { value_.store(value, std::memory_order_relaxed); }
+            void add(const double delta) noexcept { value_.fetch_add(delta, std::memory_order_relaxed); }
+            double value() const noexcept { return value_.load(std::memory_order_relaxed); }
+
+        private:
+            friend class Metrics;
+            Gauge() = default;
+            std::atomic<double> value_{0};
+        };
+
+        struct HistogramSnapshot {
+            uint64_t count = 0;
+            uint64_t sum   = 0;
+            /// Непустые корзины по возрастанию: верхняя граница (включительно) и число значений
+            std::vector<std::pair<uint64_t, uint64_t>> buckets;
+
+            /// \return Верхняя граница корзины, в которую попадает квантиль q из [0, 1]; 0 - значений нет
+            uint64_t quantile(double q) const;
+        };
+
+        /// \brief Лог-линейная гистограмма целых значений (например, задержек в наносекундах)
+        /// \details Значения до 15 хранятся точно, далее каждая степень двойки делится на 8 корзин: относительная
+        /// погрешность не больше 12.5% во всём диапазоне uint64_t
+        class Histogram
+        {
+        public:
+            static constexpr unsigned sub_bits   = 3;
+            static constexpr size_t bucket_count = (64 - sub_bits + 1) << sub_bits;
+
+            void record(const uint64_t value) noexcept
+            {
+                Shard &shard = shards_[threadSlot() & mask_];
+                shard.buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+                shard.sum.fetch_add(value, std::memory_order_relaxed);
+            }
+            HistogramSnapshot snapshot() const;
+
+            static size_t bucketOf(const uint64_t value) noexcept
+            {
+                if (value < (uint64_t(2) << sub_bits)) return value;
+                const unsigned shift = std::bit_width(value) - 1 - sub_bits;
+                return (size_t(shift) << sub_bits) + (value >> shift);
+            }
+            /// \return Наибольшее значение, попадающее в корзину bucket
+            static uint64_t upperBound(size_t bucket) noexcept;
+
+        private:
+            friend class Metrics;
+            explicit Histogram(size_t shards);
+
+            struct alignas(64) Shard {
+                std::array<std::atomic<uint64_t>, bucket_count> buckets{};
+                std::atomic<uint64_t> sum{0};
+            };
+            std::unique_ptr<Shard[]> shards_;
+            size_t mask_;
+        };
+
+        struct MetricSnapshot {
+            std::string name;
+            std::string help;
+            std::string owner;
+            Type type;
+            double value = 0; ///< Для счётчика и датчика
+            HistogramSnapshot histogram;
+        };
+
+        static std::string name();
+        /// Удаляется после моделей плагинов (они могут обновлять метрики в деструкторах), но до EventLoop
+        int deleteOrder() override { return 997; }
+        void init() override;
+        void postInit() override;
+        ~Metrics() override;
+
+        /// \brief Получить метрику по имени, создав её при первом обращении
+        /// \param owner Владелец (метка plugin в Prometheus), по умолчанию - LOG_NAME вызывающего плагина
+        /// \return Ссылка действительна до удаления модели. Если имя занято метрикой другого типа, возвращается
+        /// отдельная метрика, не попадающая в экспорт
+        Counter &counter(const std::string &name, const std::string &help = "", std::string_view owner = LOG_NAME);
+        Gauge &gauge(const std::string &name, const std::string &help = "", std::string_view owner = LOG_NAME);
+        Histogram &histogram(const std::string &name, const std::string &help = "",
+                             std::string_view owner = LOG_NAME);
+
+        /// \brief Значения всех метрик, упорядоченных по имени
+        std::vector<MetricSnapshot> snapshot() const;
+        /// \brief Все метрики в текстовом формате Prometheus
+        std::string prometheus() const;
+
+        /// \brief Номер ячейки вызывающего потока: выдаётся по кругу при первом обращении потока
+        static size_t threadSlot() noexcept
+        {
+            thread_local const size_t slot = nextSlot();
+            return slot;
+        }
+
+    private:
+        friend class Core;
+
+        struct Entry {
+            std::string help;
+            std::string owner;
+            Type type;
+            std::unique_ptr<Counter> counter;
+            std::unique_ptr<Gauge> gauge;
+            std::unique_ptr<Histogram> histogram;
+        };
+
+        static size_t nextSlot() noexcept;
+        Entry &entry(const std::string &name, const std::string &help, std::string_view owner, Type type);
+        void dump() const;
+        void listen(const std::string &path);
+        void serve(int client, bool http);
+        /// \brief Отправить клиенту сколько примет сокет, остаток - по EPOLLOUT
+        void sendResponse(int client);
+        void disconnect(int client);
+
+        EventLoop *loop_         = nullptr;
+        size_t counter_shards_   = 1;
+        size_t histogram_shards_ = 1;
+
+        mutable std::mutex mutex_;
+        std::map<std::string, Entry> entries_;
+        /// Метрики, запрошенные с типом, отличным от уже зарегистрированного
+        std::deque<Entry> detached_;
+
+        uint64_t dump_timer_ = 0;
+        int listen_fd_       = -1;
+        size_t max_clients_  = 16; ///< METRICS_MAX_CLIENTS: сверх него соединения сразу закрываются
+        std::string socket_path_;
+
+        struct Client {
+            uint64_t timer = 0;   ///< Ответ без запроса, после запроса - предельное время отправки
+            std::string response; ///< Пустой - запрос ещё не получен
+            size_t sent = 0;
+        };
+        /// Подключённые клиенты по дескриптору
+        std::map<int, Client> clients_;
+    };
+}
@@ -0,0 +1,142 @@
+#include "PersistentRegion.hpp"
+#include "Logger/Log.hpp"
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace d3156::PluginCore
+{
+    struct PersistentRegion::Header {
+        uint64_t magic;
+        uint32_t layout;
+        uint32_t state;
+        uint64_t key;
+        uint64_t size;
+    };
+
+    namespace
+    {
+        constexpr uint64_t region_magic  = 0x4E4F494745524350ULL; // "PCREGION"
+        constexpr uint32_t region_layout = 1;
+        /// Данные начинаются с новой страницы: крупные структуры остаются выровненными
+        constexpr size_t data_offset = 4096;
+
+        enum State : uint32_t { IN_USE = 1, CLOSED = 2, DISCARDED = 3 };
+
+        uint64_t fnv1a(const std::string &str, uint64_t hash = 0xcbf29ce484222325ULL)
+        {
+            for (const unsigned char c : str) hash = (hash ^ c) * 0x100000001b3ULL;
+            return hash;
+        }
+
+        std::string fileName(const std::string &name)
+        {
+            std::string out;
+            for (const char c : name)
+                out += std::isalnum(static_cast<unsigned char>(c)) || std::strchr("._:-", c) ? c : '_';
+            return out;
+        }
+
+        /// Файлы прежних версий модели <Name>_*.region больше не нужны
+        void removeOtherVersions(const fs::path &dir, const std::string &name, const fs::path &keep)
+        {
+            const std::string prefix = fileName(name.substr(0, name.find_first_of('_'))) + "_";
+            std::error_code ec;
+            for (const auto &de : fs::directory_iterator(dir, ec)) {
+                const std::string file = de.path().filename().string();
+                if (de.path() == keep || !file.starts_with(prefix) || !file.ends_with(".region")) continue;
+                G_LOG(0, "Persistent region of another version removed: " << de.path().string());
+                fs::remove(de.path(), ec);
+            }
+        }
+    }
+
+    std::string PersistentRegion::dirFromEnv()
+    {
+        if (const char *dir = std::getenv("MODELS_PERSIST_DIR")) return dir;
+        return std::string("/dev/shm/PluginCore.") + program_invocation_short_name;
+    }
+
+    std::unique_ptr<PersistentRegion> PersistentRegion::open(const std::string &dir, const std::string &name,
+                                                             const std::string &owner, const size_t size)
+    {
+        std::error_code ec;
+        fs::create_directories(dir, ec);
+        const fs::path path = fs::path(dir) / (fileName(name) + ".region");
+        const int fd        = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            R_LOG(0, "Cannot open persistent region " << path.string() << ": " << std::strerror(errno));
+            return nullptr;
+        }
+        std::unique_ptr<PersistentRegion> region(new PersistentRegion);
+        region->fd_ = fd;
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            R_LOG(0, "Persistent region " << path.string() << " is used by another process");
+            return nullptr;
+        }
+        const uint64_t key = fnv1a(owner, fnv1a(name));
+        const size_t total = data_offset + size;
+        struct stat st{};
+        fstat(fd, &st);
+        const bool same_size = static_cast<size_t>(st.st_size) == total;
+
+        /// Проверка заголовка без отображения всей области
+        Header header{};
+        const bool readable = same_size && pread(fd, &header, sizeof(header), 0) == sizeof(header);
+        const bool valid    = readable && header.magic == region_magic && header.layout == region_layout &&
+                           header.key == key && header.size == size;
+        if (valid && header.state == DISCARDED)
+            G_LOG(0, "Persistent region " << path.string() << " was discarded by the model, starting clean");
+        else if (valid && header.state != CLOSED)
+            Y_LOG(0, "Persistent region " << path.string() << " was not closed cleanly, starting clean");
+        else if (st.st_size > 0 && !valid)
+            G_LOG(0, "Persistent region " << path.string() << " belongs to another version or size, starting clean");
+        region->attached_ = valid && header.state == CLOSED;
+
+        if (!region->attached_ && ftruncate(fd, 0) != 0) {
+            R_LOG(0, "Cannot resize persistent region " << path.string() << ": " << std::strerror(errno));
+            return nullptr;
+        }
+        /// Страницы выделяются сразу: заполненный /dev/shm - ошибка здесь, а не SIGBUS при записи в init()
+        if (const int rc = posix_fallocate(fd, 0, static_cast<off_t>(total)); rc != 0) {
+            R_LOG(0, "Cannot allocate persistent region " << path.string() << ": " << std::strerror(rc));
+            return nullptr;
+        }
+        void *map = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            R_LOG(0, "Cannot map persistent region " << path.string() << ": " << std::strerror(errno));
+            return nullptr;
+        }
+        region->map_      = map;
+        region->map_size_ = total;
+        region->data_     = static_cast<char *>(map) + data_offset;
+        region->size_     = size;
+
+        auto *mapped = static_cast<Header *>(map);
+        if (!region->attached_) {
+            *mapped = Header{region_magic, region_layout, IN_USE, key, size};
+            removeOtherVersions(dir, name, path);
+        } else
+            mapped->state = IN_USE;
+        G_LOG(0, "Persistent region " << path.string() << " (" << size << " bytes) "
+                                      << (region->attached_ ? "attached" : "created"));
+        return region;
+    }
+
+    PersistentRegion::~PersistentRegion()
+    {
+        if (map_) {
+            static_cast<Header *>(map_)->state = discard_ ? DISCARDED : CLOSED;
+            munmap(map_, map_size_);
+        }
+        if (fd_ >= 0) close(fd_);
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace d3156::PluginCore
+{
+    /// \brief Область памяти модели, которая переживает перезапуск процесса
+    /// \details Файл <каталог>/<name() модели>.region отображается в память (MAP_SHARED). Каталог -
+    /// MODELS_PERSIST_DIR, по умолчанию /dev/shm/PluginCore.<имя программы>; пустое значение отключает области.
+    /// В заголовке файла хранятся хэш имени модели и FULL_NAME плагина, размер и признак корректного закрытия:
+    /// данные прежнего процесса возвращаются (attached()), только если всё совпало и процесс закрыл область при
+    /// удалении модели. Иначе (новая версия модели или плагина, другой размер, аварийное завершение) область
+    /// обнуляется. Файл блокируется (flock), поэтому два процесса одну область не получат.
+    /// \note Адрес области меняется между запусками: храните в ней смещения, а не указатели
+    class PersistentRegion
+    {
+    public:
+        /// \return Каталог областей, пустой - области отключены
+        static std::string dirFromEnv();
+        /// \param owner Плагин, создавший модель: FULL_NAME, если плагин его экспортирует, иначе имя плагина. Плагины
+        /// регистрируют модели в порядке имён, поэтому у общей модели это первый по имени плагин, её регистрирующий
+        /// \note Место под область выделяется сразу (posix_fallocate): нехватка памяти в /dev/shm - ошибка open()
+        /// \return nullptr, если файл не удалось создать, выделить под него место, отобразить или он занят другим
+        /// процессом
+        static std::unique_ptr<PersistentRegion> open(const std::string &dir, const std::string &name,
+                                                      const std::string &owner, size_t size);
+        ~PersistentRegion();
+
+        PersistentRegion(const PersistentRegion &)            = delete;
+        PersistentRegion &operator=(const PersistentRegion &) = delete;
+
+        void *data() const { return data_; }
+        size_t size() const { return size_; }
+        /// \return true - в области данные прежнего процесса, false - область новая и обнулена
+        bool attached() const { return attached_; }
+        /// \brief Не сохранять данные: следующий запуск получит чистую область (например, данные не согласованы)
+        void discard() { discard_ = true; }
+
+    private:
+        struct Header;
+        PersistentRegion() = default;
+
+        int fd_          = -1;
+        void *map_       = nullptr;
+        size_t map_size_ = 0;
+        void *data_      = nullptr;
+        size_t size_     = 0;
+        bool attached_   = false;
+        bool discard_    = false;
+    };
+}
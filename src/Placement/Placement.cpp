@@ -0,0 +1,271 @@
+#include "Placement.hpp"
+#include "Logger/Log.hpp"
+#include "Utils/ParallelFor.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace d3156::PluginCore
+{
+    namespace
+    {
+        /// Режимы set_mempolicy(2) из <linux/mempolicy.h>: libnuma не требуется
+        constexpr int mpol_default    = 0;
+        constexpr int mpol_preferred  = 1;
+        constexpr int mpol_bind       = 2;
+        constexpr int mpol_interleave = 3;
+        /// Размер маски узлов для get_mempolicy: не меньше числа возможных узлов ядра
+        constexpr size_t max_nodes = 1024;
+        constexpr size_t word_bits = 8 * sizeof(unsigned long);
+
+        /// Заполняется в load() до запуска потоков, дальше только читается
+        std::map<std::string, Placement::Policy, std::less<>> policies;
+
+        std::string_view trim(std::string_view s)
+        {
+            while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+            while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+            return s;
+        }
+
+        /// \brief Разобрать список вида "0-3,8,10-11" (как в /sys и taskset -c)
+        bool parseList(std::string_view s, std::vector<int> &out)
+        {
+            s = trim(s);
+            if (s.empty()) return false;
+            while (!s.empty()) {
+                const size_t comma    = s.find(',');
+                std::string_view item = trim(s.substr(0, comma));
+                s                     = comma == std::string_view::npos ? std::string_view{} : s.substr(comma + 1);
+                int first = 0, last = 0;
+                const size_t dash = item.find('-');
+                const auto lo     = item.substr(0, dash);
+                if (std::from_chars(lo.data(), lo.data() + lo.size(), first).ptr != lo.data() + lo.size() ||
+                    lo.empty())
+                    return false;
+                last = first;
+                if (dash != std::string_view::npos) {
+                    const auto hi = item.substr(dash + 1);
+                    if (std::from_chars(hi.data(), hi.data() + hi.size(), last).ptr != hi.data() + hi.size() ||
+                        hi.empty())
+                        return false;
+                }
+                if (first < 0 || last < first || last >= CPU_SETSIZE) return false;
+                for (int i = first; i <= last; ++i) out.push_back(i);
+            }
+            return true;
+        }
+
+        /// \brief Обратно в компактный вид "0-3,8"
+        std::string formatList(const std::vector<int> &list)
+        {
+            std::ostringstream out;
+            for (size_t i = 0; i < list.size();) {
+                size_t j = i;
+                while (j + 1 < list.size() && list[j + 1] == list[j] + 1) ++j;
+                if (i) out << ',';
+                out << list[i];
+                if (j > i) out << '-' << list[j];
+                i = j + 1;
+            }
+            return out.str();
+        }
+
+        bool parsePolicy(std::string_view s, Placement::Policy &policy)
+        {
+            const size_t at          = s.find('@');
+            const std::string_view c = trim(s.substr(0, at));
+            if (!c.empty() && !parseList(c, policy.cpus)) return false;
+            if (at == std::string_view::npos) return !policy.cpus.empty();
+            std::string_view nodes = trim(s.substr(at + 1));
+            policy.memory          = Placement::Memory::Bind;
+            if (const size_t colon = nodes.find(':'); colon != std::string_view::npos) {
+                const auto mode = trim(nodes.substr(0, colon));
+                if (mode == "bind")
+                    policy.memory = Placement::Memory::Bind;
+                else if (mode == "preferred")
+                    policy.memory = Placement::Memory::Preferred;
+                else if (mode == "interleave")
+                    policy.memory = Placement::Memory::Interleave;
+                else
+                    return false;
+                nodes = nodes.substr(colon + 1);
+            }
+            if (!parseList(nodes, policy.nodes)) return false;
+            /// preferred - один узел
+            return policy.memory != Placement::Memory::Preferred || policy.nodes.size() == 1;
+        }
+
+        std::string describe(const Placement::Policy &policy)
+        {
+            std::string out = policy.cpus.empty() ? "any CPU" : "CPU " + formatList(policy.cpus);
+            switch (policy.memory) {
+            case Placement::Memory::FirstTouch: return out + ", memory first touch";
+            case Placement::Memory::Bind: return out + ", memory bind " + formatList(policy.nodes);
+            case Placement::Memory::Preferred: return out + ", memory preferred " + formatList(policy.nodes);
+            case Placement::Memory::Interleave: return out + ", memory interleave " + formatList(policy.nodes);
+            }
+            return out;
+        }
+
+        long setMempolicy(const int mode, const unsigned long *mask, const unsigned long maxnode)
+        {
+            return syscall(SYS_set_mempolicy, mode, mask, maxnode);
+        }
+
+        long getMempolicy(int *mode, unsigned long *mask, const unsigned long maxnode)
+        {
+            return syscall(SYS_get_mempolicy, mode, mask, maxnode, nullptr, 0UL);
+        }
+
+        /// \brief Применить политику к вызывающему потоку, ошибки - в лог
+        void applyPolicy(const std::string_view plugin, const Placement::Policy &policy)
+        {
+            if (!policy.cpus.empty()) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                for (const int cpu : policy.cpus)
+                    if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+                if (sched_setaffinity(0, sizeof(set), &set) != 0)
+                    Y_LOG(0, "Placement of " << plugin << ": cannot set CPU " << formatList(policy.cpus) << ": "
+                                             << std::strerror(errno));
+            }
+            if (policy.nodes.empty()) return;
+            std::vector<unsigned long> mask(max_nodes / word_bits, 0);
+            for (const int node : policy.nodes)
+                if (static_cast<size_t>(node) < max_nodes) mask[node / word_bits] |= 1UL << (node % word_bits);
+            const int mode = policy.memory == Placement::Memory::Preferred    ? mpol_preferred
+                             : policy.memory == Placement::Memory::Interleave ? mpol_interleave
+                                                                              : mpol_bind;
+            /// Ядро считает maxnode на единицу больше числа бит маски
+            if (setMempolicy(mode, mask.data(), max_nodes + 1) != 0)
+                Y_LOG(0, "Placement of " << plugin << ": cannot set memory policy for nodes "
+                                         << formatList(policy.nodes) << ": " << std::strerror(errno));
+        }
+
+        /// \brief Узлы NUMA и их CPU из /sys; пусто - ядро без NUMA
+        std::map<int, std::string> topology()
+        {
+            std::map<int, std::string> nodes;
+            std::error_code ec;
+            for (const auto &entry : fs::directory_iterator("/sys/devices/system/node", ec)) {
+                const std::string name = entry.path().filename().string();
+                int node               = 0;
+                if (!name.starts_with("node") ||
+                    std::from_chars(name.data() + 4, name.data() + name.size(), node).ptr != name.data() + name.size())
+                    continue;
+                std::ifstream in(entry.path() / "cpulist");
+                std::string cpus;
+                std::getline(in, cpus);
+                nodes[node] = std::string(trim(cpus));
+            }
+            return nodes;
+        }
+    }
+
+    void Placement::load(const std::vector<std::string> &plugins)
+    {
+        const auto nodes = topology();
+        std::ostringstream map;
+        map << "Topology: " << availableCpus() << " CPU available (" << std::thread::hardware_concurrency()
+            << " online)";
+        if (nodes.empty()) map << ", no NUMA information";
+        for (const auto &[node, cpus] : nodes) map << "\n  NUMA node " << node << ": CPU " << cpus;
+        G_LOG(0, map.str());
+
+        policies.clear();
+        const char *val = std::getenv("PLUGINS_PLACEMENT");
+        if (val == nullptr || *val == '\0') return;
+        std::string_view spec = val;
+        while (!spec.empty()) {
+            const size_t semicolon = spec.find(';');
+            const auto entry       = trim(spec.substr(0, semicolon));
+            spec = semicolon == std::string_view::npos ? std::string_view{} : spec.substr(semicolon + 1);
+            if (entry.empty()) continue;
+            const size_t eq = entry.find('=');
+            Policy policy;
+            if (eq == std::string_view::npos || trim(entry.substr(0, eq)).empty() ||
+                !parsePolicy(entry.substr(eq + 1), policy)) {
+                R_LOG(0, "PLUGINS_PLACEMENT: invalid entry '" << entry << "' ignored");
+                continue;
+            }
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            sched_getaffinity(0, sizeof(allowed), &allowed);
+            for (const int cpu : policy.cpus)
+                if (!CPU_ISSET(cpu, &allowed))
+                    Y_LOG(0, "PLUGINS_PLACEMENT: CPU " << cpu << " of '" << entry << "' is not available to the process");
+            for (const int node : policy.nodes)
+                if (!nodes.empty() && !nodes.contains(node))
+                    Y_LOG(0, "PLUGINS_PLACEMENT: NUMA node " << node << " of '" << entry << "' does not exist");
+            policies[std::string(trim(entry.substr(0, eq)))] = std::move(policy);
+        }
+        for (const auto &[name, policy] : policies)
+            if (name != "*" && name != "Executor" && name != "Core" &&
+                std::find(plugins.begin(), plugins.end(), name) == plugins.end())
+                Y_LOG(0, "PLUGINS_PLACEMENT: plugin " << name << " is not loaded");
+        for (const auto &plugin : plugins)
+            if (const Policy *p = policy(plugin)) G_LOG(0, "Placement of " << plugin << ": " << describe(*p));
+        for (const char *core : {"Core", "Executor"})
+            if (const auto it = policies.find(core); it != policies.end())
+                G_LOG(0, "Placement of " << core << ": " << describe(it->second));
+    }
+
+    const Placement::Policy *Placement::policy(std::string_view plugin)
+    {
+        if (policies.empty()) return nullptr;
+        /// Перезагружаемая версия плагина (<Name>@reload) размещается как прежняя
+        plugin = plugin.substr(0, plugin.find('@'));
+        if (const auto it = policies.find(plugin); it != policies.end()) return &it->second;
+        /// "*" относится только к плагинам: модели Core и пул задаются явно
+        if (plugin == "Core" || plugin == "Executor") return nullptr;
+        const auto it = policies.find("*");
+        return it != policies.end() ? &it->second : nullptr;
+    }
+
+    void Placement::apply(const std::string_view plugin)
+    {
+        if (const Policy *p = policy(plugin)) applyPolicy(plugin, *p);
+    }
+
+    std::thread Placement::thread(std::function<void()> fn, const std::string_view owner)
+    {
+        return std::thread([fn = std::move(fn), owner = std::string(owner)] {
+            apply(owner);
+            fn();
+        });
+    }
+
+    Placement::Scope::Scope(const std::string_view plugin)
+    {
+        const Policy *p = policy(plugin);
+        if (p == nullptr) return;
+        active_ = true;
+        CPU_ZERO(&cpus_);
+        if (sched_getaffinity(0, sizeof(cpus_), &cpus_) != 0) CPU_ZERO(&cpus_);
+        if (!p->nodes.empty()) {
+            nodes_.assign(max_nodes / word_bits, 0);
+            if (getMempolicy(&mode_, nodes_.data(), max_nodes) != 0) nodes_.clear();
+        }
+        applyPolicy(plugin, *p);
+    }
+
+    Placement::Scope::~Scope()
+    {
+        if (!active_) return;
+        if (CPU_COUNT(&cpus_) > 0) sched_setaffinity(0, sizeof(cpus_), &cpus_);
+        if (!nodes_.empty())
+            setMempolicy(mode_, mode_ == mpol_default ? nullptr : nodes_.data(),
+                         mode_ == mpol_default ? 0 : max_nodes + 1);
+    }
+}
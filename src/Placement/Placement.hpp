@@ -0,0 +1,62 @@
+#pragma once
+#include <functional>
+#include <sched.h>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifndef LOG_NAME
+#define LOG_NAME "UNKNOWN_SOURCE"
+#endif
+
+namespace d3156::PluginCore
+{
+    /// \brief Размещение потоков и памяти плагинов по CPU и узлам NUMA
+    /// \details PLUGINS_PLACEMENT="<Плагин>=<CPU>[@[<режим>:]<узлы>];...", например
+    /// "Market=0-7,16-23@0;Risk=8-15@interleave:0-1;*=0-31". Имя - как в lib<Name>.so, "*" - остальные плагины,
+    /// "Executor" - рабочие потоки общего пула. CPU задают маску affinity, узлы - политику памяти потока: bind
+    /// (по умолчанию), preferred или interleave. Без узлов память размещается по первому обращению (first touch),
+    /// то есть на узле CPU из маски.
+    /// Core применяет размещение плагина к потоку на время его registerModels, postInit и init/postInit его моделей:
+    /// память, выделенная в init(), размещается по политике плагина, а потоки, запущенные плагином в этих вызовах,
+    /// наследуют маску и политику. Для потоков, запускаемых позже, есть thread().
+    class Placement
+    {
+    public:
+        enum class Memory { FirstTouch, Bind, Preferred, Interleave };
+
+        struct Policy {
+            std::vector<int> cpus;  ///< Пустой - маска не меняется
+            std::vector<int> nodes; ///< Пустой - политика памяти не меняется
+            Memory memory = Memory::FirstTouch;
+        };
+
+        /// \brief Разобрать PLUGINS_PLACEMENT и вывести в лог топологию и размещение плагинов plugins
+        static void load(const std::vector<std::string> &plugins);
+        /// \return Политика плагина (или "*"), nullptr - размещение не задано
+        static const Policy *policy(std::string_view plugin);
+        /// \brief Применить политику плагина к вызывающему потоку
+        static void apply(std::string_view plugin);
+
+        /// \brief Поток, выполняющий fn с размещением плагина owner
+        static std::thread thread(std::function<void()> fn, std::string_view owner = LOG_NAME);
+
+        /// \brief Применить политику плагина к потоку до конца блока и затем восстановить прежние маску и политику
+        class Scope
+        {
+        public:
+            explicit Scope(std::string_view plugin);
+            ~Scope();
+
+            Scope(const Scope &)            = delete;
+            Scope &operator=(const Scope &) = delete;
+
+        private:
+            bool active_ = false;
+            cpu_set_t cpus_{};
+            int mode_ = 0;
+            std::vector<unsigned long> nodes_;
+        };
+    };
+}
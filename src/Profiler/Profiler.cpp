@@ -0,0 +1,108 @@
+#include "Profiler.hpp"
+#include "Logger/Log.hpp"
+#include "Utils/Json.hpp"
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace d3156::PluginCore
+{
+    namespace
+    {
+        int64_t cpuNs(const bool process)
+        {
+            timespec ts{};
+            clock_gettime(process ? CLOCK_PROCESS_CPUTIME_ID : CLOCK_THREAD_CPUTIME_ID, &ts);
+            return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+        }
+
+        uint64_t threadId() { return static_cast<uint64_t>(syscall(SYS_gettid)); }
+    }
+
+    Profiler::Profiler() : origin_(std::chrono::steady_clock::now())
+    {
+        if (const char *path = std::getenv("PLUGINS_PROFILE")) path_ = path;
+        if (const char *top = std::getenv("PLUGINS_PROFILE_TOP")) {
+            try {
+                top_ = std::stoul(top);
+            } catch (...) {
+            }
+        }
+    }
+
+    Profiler::Scope::Scope(Profiler &profiler, std::string name, const char *category)
+        : profiler_(profiler.enabled() ? &profiler : nullptr), category_(category),
+          process_cpu_(std::string_view(category) == "phase")
+    {
+        if (!profiler_) return;
+        name_         = std::move(name);
+        start_        = std::chrono::steady_clock::now();
+        cpu_start_ns_ = cpuNs(process_cpu_);
+    }
+
+    Profiler::Scope::~Scope()
+    {
+        if (!profiler_) return;
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+        const auto end = std::chrono::steady_clock::now();
+        profiler_->record({std::move(name_), category_, duration_cast<microseconds>(start_ - profiler_->origin_).count(),
+                           duration_cast<microseconds>(end - start_).count(),
+                           (cpuNs(process_cpu_) - cpu_start_ns_) / 1000, threadId()});
+    }
+
+    void Profiler::record(Event &&event)
+    {
+        std::lock_guard lock(mutex_);
+        events_.push_back(std::move(event));
+    }
+
+    void Profiler::finish()
+    {
+        if (!enabled()) return;
+        std::lock_guard lock(mutex_);
+        writeTrace();
+        logSummary();
+    }
+
+    void Profiler::writeTrace() const
+    {
+        std::string out = "{\"traceEvents\":[\n";
+        const auto pid  = std::to_string(getpid());
+        for (size_t i = 0; i < events_.size(); ++i) {
+            const auto &e = events_[i];
+            out += "{\"name\":";
+            appendJsonString(out, e.name);
+            out += ",\"cat\":\"" + std::string(e.category) + "\",\"ph\":\"X\",\"ts\":" + std::to_string(e.start_us) +
+                   ",\"dur\":" + std::to_string(e.wall_us) + ",\"pid\":" + pid + ",\"tid\":" + std::to_string(e.tid) +
+                   ",\"args\":{\"cpu_us\":" + std::to_string(e.cpu_us) + "}}";
+            out += i + 1 < events_.size() ? ",\n" : "\n";
+        }
+        out += "],\"displayTimeUnit\":\"ms\"}\n";
+        std::ofstream file(path_, std::ios::trunc);
+        file << out;
+        if (!file) {
+            R_LOG(0, "Cannot write startup profile to " << path_);
+            return;
+        }
+        G_LOG(0, "Startup profile written to " << path_);
+    }
+
+    void Profiler::logSummary() const
+    {
+        std::vector<const Event *> phases, calls;
+        for (const auto &e : events_) (std::string_view(e.category) == "phase" ? phases : calls).push_back(&e);
+        const auto slower = [](const Event *a, const Event *b) { return a->wall_us > b->wall_us; };
+        G_LOG(0, "Startup phases:");
+        for (const auto *e : phases)
+            G_LOG(0, "  " << e->name << ": wall " << e->wall_us / 1000.0 << " ms, cpu " << e->cpu_us / 1000.0 << " ms");
+        std::sort(calls.begin(), calls.end(), slower);
+        if (calls.size() > top_) calls.resize(top_);
+        G_LOG(0, "Top " << calls.size() << " slowest plugin/model calls:");
+        for (const auto *e : calls)
+            G_LOG(0, "  [" << e->category << "] " << e->name << ": wall " << e->wall_us / 1000.0 << " ms, cpu "
+                           << e->cpu_us / 1000.0 << " ms");
+    }
+}
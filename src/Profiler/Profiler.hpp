@@ -0,0 +1,66 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace d3156::PluginCore
+{
+    /// \brief Профилировщик этапов запуска Core
+    /// \details Включается переменной окружения PLUGINS_PROFILE=<файл.json>: по завершении запуска пишет
+    /// Chrome trace-event JSON (chrome://tracing, Perfetto) и выводит в лог PLUGINS_PROFILE_TOP (10) самых долгих
+    /// вызовов плагинов и моделей.
+    class Profiler
+    {
+    public:
+        Profiler();
+
+        bool enabled() const { return !path_.empty(); }
+
+        /// \brief RAII-замер участка кода: время по часам и процессорное время
+        /// \details Для этапа Core ("phase") - процессорное время всего процесса, т.к. этап распределяет работу по
+        /// потокам; для отдельного вызова - время текущего потока
+        class Scope
+        {
+        public:
+            /// \param category "phase" для этапа Core, "plugin" или "model" для отдельного вызова
+            Scope(Profiler &profiler, std::string name, const char *category);
+            ~Scope();
+
+            Scope(const Scope &)            = delete;
+            Scope &operator=(const Scope &) = delete;
+
+        private:
+            Profiler *profiler_;
+            std::string name_;
+            const char *category_;
+            bool process_cpu_;
+            std::chrono::steady_clock::time_point start_;
+            int64_t cpu_start_ns_ = 0;
+        };
+
+        /// \brief Записать trace-файл и вывести сводку в лог
+        void finish();
+
+    private:
+        struct Event {
+            std::string name;
+            const char *category;
+            int64_t start_us;
+            int64_t wall_us;
+            int64_t cpu_us;
+            uint64_t tid;
+        };
+
+        void record(Event &&event);
+        void writeTrace() const;
+        void logSummary() const;
+
+        std::string path_;
+        size_t top_ = 10;
+        std::chrono::steady_clock::time_point origin_;
+        std::mutex mutex_;
+        std::vector<Event> events_;
+    };
+}
@@ -0,0 +1,330 @@
+#include "Tracer.hpp"
+#include "EventLoop/EventLoop.hpp"
+#include "Utils/Json.hpp"
+#include "Utils/Watchdog.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace d3156::PluginCore
+{
+    struct Tracer::Record {
+        uint64_t trace_hi;
+        uint64_t trace_lo;
+        uint64_t span_id;
+        uint64_t parent_id;
+        int64_t start_ns;
+        int64_t end_ns;
+        uint64_t tid;
+        char name[64];
+        char component[32];
+    };
+
+    /// Кольцевой буфер потока: пишет только поток-владелец, читает только flush()
+    struct Tracer::Ring {
+        explicit Ring(const size_t capacity) : records(std::make_unique<Record[]>(capacity)), capacity(capacity) {}
+
+        std::unique_ptr<Record[]> records;
+        const size_t capacity;
+        std::atomic<uint64_t> head{0};
+        std::atomic<uint64_t> tail{0};
+        std::atomic<uint64_t> dropped{0};
+        /// false после завершения потока: пустой буфер удаляется при следующем сбросе
+        std::atomic<bool> alive{true};
+    };
+
+    namespace
+    {
+        uint64_t threadId() { return static_cast<uint64_t>(syscall(SYS_gettid)); }
+
+        /// splitmix64: идентификаторы span и выбор корневых span для записи
+        uint64_t random64(uint64_t &state)
+        {
+            if (state == 0)
+                state = (uint64_t(std::random_device{}()) << 32) ^ threadId() ^
+                        static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+            uint64_t z = (state += 0x9e3779b97f4a7c15);
+            z          = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z          = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            return z ^ (z >> 31);
+        }
+
+        uint64_t nonZeroRandom(uint64_t &state)
+        {
+            uint64_t value;
+            while ((value = random64(state)) == 0) {}
+            return value;
+        }
+
+        void copyName(char *out, const size_t size, const std::string_view name)
+        {
+            const size_t length = std::min(name.size(), size - 1);
+            std::memcpy(out, name.data(), length);
+            out[length] = '\0';
+        }
+
+        std::string hex(const uint64_t value)
+        {
+            char buffer[17];
+            std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+            return buffer;
+        }
+
+        std::atomic<uint64_t> next_tracer_id{1};
+    }
+
+    std::string Tracer::name() { return "Tracer_" PLUGIN_CORE_VERSION ":PluginCore"; }
+
+    Tracer::ThreadState &Tracer::local()
+    {
+        thread_local ThreadState state;
+        return state;
+    }
+
+    TraceContext Tracer::current()
+    {
+        const Frame *frame = local().top;
+        return frame ? frame->context : TraceContext{};
+    }
+
+    Tracer::Span::Span(Tracer *tracer, const std::string_view name, const std::string_view component,
+                       const TraceContext &parent)
+    {
+        if (tracer == nullptr || !tracer->enabled()) return;
+        ThreadState &state      = local();
+        const TraceContext from = parent ? parent : state.top ? state.top->context : TraceContext{};
+        if (from) {
+            frame_.context = from;
+            parent_id_     = from.span_id;
+        } else
+            frame_.context.sampled = tracer->sample_ == UINT64_MAX || random64(state.rng) < tracer->sample_;
+        tracer_         = tracer;
+        frame_.previous = state.top;
+        state.top       = &frame_;
+        /// Идентификаторы нужны только записываемым span: остальным достаточно передать решение о записи
+        if (!frame_.context.sampled) {
+            frame_.context.span_id = 1;
+            return;
+        }
+        if (!from) {
+            frame_.context.trace_hi = nonZeroRandom(state.rng);
+            frame_.context.trace_lo = random64(state.rng);
+        }
+        frame_.context.span_id = nonZeroRandom(state.rng);
+        copyName(name_, sizeof(name_), name);
+        copyName(component_, sizeof(component_), component);
+        start_ns_ = tracer->nowNs();
+    }
+
+    void Tracer::Span::end()
+    {
+        if (tracer_ == nullptr) return;
+        if (frame_.context.sampled) tracer_->record(*this, tracer_->nowNs());
+        /// Span, завершённый вызовом end() не в порядке вложенности, удаляется из середины стека
+        for (Frame **link = &local().top; *link; link = &(*link)->previous)
+            if (*link == &frame_) {
+                *link = frame_.previous;
+                break;
+            }
+        tracer_ = nullptr;
+    }
+
+    Tracer::Adopt::Adopt(const TraceContext &context)
+    {
+        ThreadState &state = local();
+        frame_.context     = context;
+        frame_.previous    = state.top;
+        state.top          = &frame_;
+    }
+
+    Tracer::Adopt::~Adopt() { local().top = frame_.previous; }
+
+    void Tracer::init()
+    {
+        id_             = next_tracer_id++;
+        origin_         = std::chrono::steady_clock::now();
+        origin_unix_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::system_clock::now().time_since_epoch())
+                              .count();
+        const char *path = std::getenv("TRACING_FILE");
+        if (path == nullptr || *path == '\0') return;
+        if (const char *format = std::getenv("TRACING_FORMAT")) {
+            if (std::strcmp(format, "otlp") == 0)
+                otlp_ = true;
+            else if (std::strcmp(format, "chrome") != 0)
+                Y_LOG(0, "Unknown TRACING_FORMAT " << format << ", using chrome");
+        }
+        double sample = 1;
+        if (const char *val = std::getenv("TRACING_SAMPLE")) {
+            try {
+                sample = std::clamp(std::stod(val), 0.0, 1.0);
+            } catch (...) {
+                Y_LOG(0, "Invalid TRACING_SAMPLE value " << val);
+            }
+        }
+        sample_ = sample >= 1 ? UINT64_MAX : static_cast<uint64_t>(sample * 18446744073709551616.0);
+        if (const char *val = std::getenv("TRACING_BUFFER")) {
+            try {
+                capacity_ = std::max<size_t>(std::stoul(val), 16);
+            } catch (...) {
+                Y_LOG(0, "Invalid TRACING_BUFFER value " << val);
+            }
+        }
+        path_ = path;
+        G_LOG(0, "Tracer: writing " << (otlp_ ? "otlp" : "chrome") << " traces to " << path_ << ", sample " << sample
+                                    << ", " << capacity_ << " spans per thread");
+    }
+
+    void Tracer::postInit()
+    {
+        if (!enabled() || loop_ == nullptr) return;
+        if (const auto period = Watchdog::timeoutFromEnv("TRACING_FLUSH_MS", std::chrono::milliseconds(0));
+            period.count() > 0)
+            flush_timer_ = loop_->addTimer(period, [this] { flush(); }, period);
+    }
+
+    Tracer::~Tracer()
+    {
+        if (flush_timer_ && loop_) loop_->cancelTimer(flush_timer_);
+        if (enabled()) flush();
+    }
+
+    int64_t Tracer::nowNs() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin_).count();
+    }
+
+    Tracer::Ring &Tracer::ring()
+    {
+        struct Local {
+            uint64_t tracer = 0;
+            std::shared_ptr<Ring> ring;
+            ~Local()
+            {
+                if (ring) ring->alive = false;
+            }
+        };
+        thread_local Local local;
+        if (local.tracer != id_) {
+            if (local.ring) local.ring->alive = false;
+            local.ring   = std::make_shared<Ring>(capacity_);
+            local.tracer = id_;
+            std::lock_guard lock(mutex_);
+            rings_.push_back(local.ring);
+        }
+        return *local.ring;
+    }
+
+    void Tracer::record(const Span &span, const int64_t end_ns)
+    {
+        Ring &ring          = this->ring();
+        const uint64_t head = ring.head.load(std::memory_order_relaxed);
+        if (head - ring.tail.load(std::memory_order_acquire) >= ring.capacity) {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Record &record   = ring.records[head % ring.capacity];
+        record.trace_hi  = span.frame_.context.trace_hi;
+        record.trace_lo  = span.frame_.context.trace_lo;
+        record.span_id   = span.frame_.context.span_id;
+        record.parent_id = span.parent_id_;
+        record.start_ns  = span.start_ns_;
+        record.end_ns    = end_ns;
+        thread_local const uint64_t tid = threadId();
+        record.tid                      = tid;
+        std::memcpy(record.name, span.name_, sizeof(record.name));
+        std::memcpy(record.component, span.component_, sizeof(record.component));
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+
+    void Tracer::flush()
+    {
+        std::vector<Record> records;
+        uint64_t dropped = 0;
+        {
+            std::lock_guard lock(mutex_);
+            for (const auto &ring : rings_) {
+                const uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+                const uint64_t head = ring->head.load(std::memory_order_acquire);
+                for (uint64_t i = tail; i < head; ++i) records.push_back(ring->records[i % ring->capacity]);
+                ring->tail.store(head, std::memory_order_release);
+                dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+            }
+            std::erase_if(rings_, [](const auto &ring) {
+                return !ring->alive.load() && ring->head.load() == ring->tail.load();
+            });
+        }
+        if (records.empty() && dropped == 0) return;
+        std::sort(records.begin(), records.end(),
+                  [](const Record &a, const Record &b) { return a.start_ns < b.start_ns; });
+        const std::string file = flush_timer_ ? path_ + "." + std::to_string(++flushes_) : path_;
+        std::ofstream out(file, std::ios::trunc);
+        out << (otlp_ ? otlp(records) : chrome(records));
+        if (!out) {
+            R_LOG(0, "Tracer: cannot write " << file);
+            return;
+        }
+        G_LOG(0, "Tracer: " << records.size() << " spans written to " << file
+                            << (dropped ? ", " + std::to_string(dropped) + " dropped (buffer full)" : ""));
+    }
+
+    std::string Tracer::chrome(const std::vector<Record> &records) const
+    {
+        std::string out = "{\"traceEvents\":[\n";
+        const auto pid  = std::to_string(getpid());
+        for (size_t i = 0; i < records.size(); ++i) {
+            const auto &r = records[i];
+            out += "{\"name\":";
+            appendJsonString(out, r.name);
+            out += ",\"cat\":";
+            appendJsonString(out, r.component);
+            out += ",\"ph\":\"X\",\"ts\":" + std::to_string(r.start_ns / 1000.0) +
+                   ",\"dur\":" + std::to_string((r.end_ns - r.start_ns) / 1000.0) + ",\"pid\":" + pid +
+                   ",\"tid\":" + std::to_string(r.tid) + ",\"args\":{\"trace_id\":\"" + hex(r.trace_hi) +
+                   hex(r.trace_lo) + "\",\"span_id\":\"" + hex(r.span_id) + "\"";
+            if (r.parent_id) out += ",\"parent_id\":\"" + hex(r.parent_id) + "\"";
+            out += i + 1 < records.size() ? "}},\n" : "}}\n";
+        }
+        out += "],\"displayTimeUnit\":\"ms\"}\n";
+        return out;
+    }
+
+    std::string Tracer::otlp(const std::vector<Record> &records) const
+    {
+        /// Компонент (LOG_NAME плагина) - область инструментирования OpenTelemetry
+        std::map<std::string_view, std::vector<const Record *>> scopes;
+        for (const auto &r : records) scopes[r.component].push_back(&r);
+        std::string out = "{\"resourceSpans\":[{\"resource\":{\"attributes\":[{\"key\":\"service.name\",\"value\":"
+                          "{\"stringValue\":";
+        appendJsonString(out, program_invocation_short_name);
+        out += "}},{\"key\":\"process.pid\",\"value\":{\"intValue\":\"" + std::to_string(getpid()) +
+               "\"}}]},\"scopeSpans\":[";
+        bool first_scope = true;
+        for (const auto &[component, spans] : scopes) {
+            out += first_scope ? "\n{\"scope\":{\"name\":" : ",\n{\"scope\":{\"name\":";
+            first_scope = false;
+            appendJsonString(out, component);
+            out += "},\"spans\":[";
+            for (size_t i = 0; i < spans.size(); ++i) {
+                const auto &r = *spans[i];
+                out += i ? ",\n{\"traceId\":\"" : "\n{\"traceId\":\"";
+                out += hex(r.trace_hi) + hex(r.trace_lo) + "\",\"spanId\":\"" + hex(r.span_id) + "\"";
+                if (r.parent_id) out += ",\"parentSpanId\":\"" + hex(r.parent_id) + "\"";
+                out += ",\"name\":";
+                appendJsonString(out, r.name);
+                out += ",\"kind\":1,\"startTimeUnixNano\":\"" + std::to_string(origin_unix_ns_ + r.start_ns) +
+                       "\",\"endTimeUnixNano\":\"" + std::to_string(origin_unix_ns_ + r.end_ns) +
+                       "\",\"attributes\":[{\"key\":\"thread.id\",\"value\":{\"intValue\":\"" +
+                       std::to_string(r.tid) + "\"}}]}";
+            }
+            out += "]}";
+        }
+        out += "]}]}\n";
+        return out;
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include "IModel.hpp"
+#include <chrono>
+#include <mutex>
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+/// \brief Span до конца текущего блока: TRACE_SPAN(tracer, "name"), tracer - Tracer* (nullptr - без записи)
+#define TRACE_SPAN(tracer, name) d3156::PluginCore::Tracer::Span TRACE_CONCAT(trace_span_, __LINE__)(tracer, name)
+
+namespace d3156::PluginCore
+{
+    class EventLoop;
+
+    /// \brief Контекст трассировки: передаётся между потоками и плагинами в вызовах моделей и полях событий
+    struct TraceContext {
+        uint64_t trace_hi = 0;
+        uint64_t trace_lo = 0;
+        uint64_t span_id  = 0;
+        bool sampled      = false;
+
+        explicit operator bool() const { return span_id != 0; }
+    };
+
+    /// \brief Трассировка запросов через плагины, которой владеет Core
+    /// \details Включается TRACING_FILE=<файл>. Span - RAII-замер участка: вложенные span одного потока образуют
+    /// стек (общий для всех плагинов), компонент span - LOG_NAME плагина, как в логе. Решение о записи принимается
+    /// для корневого span с вероятностью TRACING_SAMPLE (по умолчанию 1) и наследуется дочерними.
+    /// Завершённые span пишутся без блокировок в кольцевой буфер потока (TRACING_BUFFER записей, по умолчанию 4096;
+    /// при переполнении span отбрасываются) и сбрасываются в файл при удалении модели и раз в TRACING_FLUSH_MS мс,
+    /// если задано (тогда файлы нумеруются: <файл>.1, <файл>.2, ...). TRACING_FORMAT: chrome (chrome://tracing,
+    /// Perfetto, по умолчанию) или otlp (JSON OpenTelemetry).
+    /// Задачи Executor выполняются в контексте span, из которого поставлены.
+    class Tracer final : public IModel
+    {
+        /// Элемент стека контекстов потока: span или принятый контекст
+        struct Frame {
+            TraceContext context;
+            Frame *previous = nullptr;
+        };
+        /// Состояние потока: один стек на процесс, поэтому span вложены и через границы плагинов
+        struct ThreadState {
+            Frame *top   = nullptr;
+            uint64_t rng = 0;
+        };
+
+    public:
+        class Span
+        {
+        public:
+            /// \param parent Контекст из другого потока или плагина, по умолчанию - текущий span потока
+            Span(Tracer *tracer, std::string_view name, std::string_view component = LOG_NAME,
+                 const TraceContext &parent = {});
+            ~Span() { end(); }
+
+            Span(const Span &)            = delete;
+            Span &operator=(const Span &) = delete;
+
+            /// \brief Завершить span до конца блока
+            void end();
+            TraceContext context() const { return frame_.context; }
+
+        private:
+            friend class Tracer;
+            Tracer *tracer_ = nullptr;
+            Frame frame_;
+            uint64_t parent_id_ = 0;
+            int64_t start_ns_   = 0;
+            char name_[64];
+            char component_[32];
+        };
+
+        /// \brief Сделать контекст из другого потока текущим до конца блока: span блока станут его дочерними
+        class Adopt
+        {
+        public:
+            explicit Adopt(const TraceContext &context);
+            ~Adopt();
+
+            Adopt(const Adopt &)            = delete;
+            Adopt &operator=(const Adopt &) = delete;
+
+        private:
+            Frame frame_;
+        };
+
+        static std::string name();
+        /// Удаляется после моделей плагинов, чтобы span из их деструкторов попали в файл
+        int deleteOrder() override { return 996; }
+        void init() override;
+        void postInit() override;
+        ~Tracer() override;
+
+        bool enabled() const { return !path_.empty(); }
+        /// \return Контекст текущего span потока, пустой - span нет
+        static TraceContext current();
+        /// \brief Записать накопленные span в файл
+        void flush();
+
+    private:
+        friend class Core;
+        struct Record;
+        struct Ring;
+
+        static ThreadState &local();
+        void record(const Span &span, int64_t end_ns);
+        Ring &ring();
+        int64_t nowNs() const;
+        std::string chrome(const std::vector<Record> &records) const;
+        std::string otlp(const std::vector<Record> &records) const;
+
+        EventLoop *loop_ = nullptr;
+        std::string path_;
+        bool otlp_            = false;
+        uint64_t sample_      = 0; ///< Порог случайного числа для записи корневого span
+        size_t capacity_      = 4096;
+        uint64_t flush_timer_ = 0;
+        size_t flushes_       = 0;
+        uint64_t id_          = 0; ///< Отличает буферы потоков этого экземпляра от буферов прежних
+        std::chrono::steady_clock::time_point origin_;
+        int64_t origin_unix_ns_ = 0;
+
+        std::mutex mutex_;
+        std::vector<std::shared_ptr<Ring>> rings_;
+    };
+}
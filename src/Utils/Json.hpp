@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace d3156
+{
+    /// \brief Дописать строку в out в виде JSON-строки (в кавычках, с экранированием)
+    inline void appendJsonString(std::string &out, const std::string_view str)
+    {
+        out += '"';
+        for (const char c : str) {
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char buf[8];
+                        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                        out += buf;
+                    } else
+                        out += c;
+            }
+        }
+        out += '"';
+    }
+}
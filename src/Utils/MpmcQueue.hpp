@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+
+namespace d3156
+{
+    /// \brief Ограниченная lock-free очередь (D. Vyukov bounded MPMC) на кольцевом буфере
+    /// \note Ёмкость округляется вверх до степени двойки
+    template <class T> class MpmcQueue
+    {
+        static constexpr size_t cache_line = 64;
+
+        struct Cell {
+            std::atomic<size_t> sequence;
+            std::optional<T> data;
+        };
+
+    public:
+        explicit MpmcQueue(size_t capacity)
+        {
+            size_t size = 2;
+            while (size < capacity) size <<= 1;
+            mask_  = size - 1;
+            cells_ = std::make_unique<Cell[]>(size);
+            for (size_t i = 0; i < size; ++i) cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        MpmcQueue(const MpmcQueue &)            = delete;
+        MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+        size_t capacity() const { return mask_ + 1; }
+
+        /// \return false, если очередь заполнена
+        template <class U> bool tryPush(U &&value)
+        {
+            size_t pos = tail_.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell &cell      = cells_[pos & mask_];
+                const size_t sq = cell.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(sq) - static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0) {
+                    if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        cell.data.emplace(std::forward<U>(value));
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0)
+                    return false;
+                else
+                    pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+
+        /// \return false, если очередь пуста
+        bool tryPop(T &out)
+        {
+            size_t pos = head_.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell &cell      = cells_[pos & mask_];
+                const size_t sq = cell.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(sq) - static_cast<std::ptrdiff_t>(pos + 1);
+                if (diff == 0) {
+                    if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        out = std::move(*cell.data);
+                        cell.data.reset();
+                        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0)
+                    return false;
+                else
+                    pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+
+        /// \brief Приблизительный размер очереди (точен только при отсутствии конкурентных операций)
+        size_t sizeApprox() const
+        {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            const size_t head = head_.load(std::memory_order_relaxed);
+            return tail > head ? tail - head : 0;
+        }
+
+    private:
+        size_t mask_ = 0;
+        std::unique_ptr<Cell[]> cells_;
+        alignas(cache_line) std::atomic<size_t> tail_{0};
+        alignas(cache_line) std::atomic<size_t> head_{0};
+    };
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace d3156
+{
+    /// \brief Число CPU, доступных процессу по маске affinity (taskset, cgroup cpuset)
+    inline size_t availableCpus()
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+            if (const int count = CPU_COUNT(&set); count > 0) return static_cast<size_t>(count);
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /// \brief Число потоков из переменной окружения: 0 - по числу доступных CPU, не задана или ошибка - def
+    inline size_t threadsFromEnv(const char *env, const size_t def = 1)
+    {
+        const char *val = std::getenv(env);
+        if (val == nullptr) return def;
+        try {
+            if (const size_t threads = std::stoul(val)) return threads;
+        } catch (...) {
+            return def;
+        }
+        return availableCpus();
+    }
+
+    /// \brief Выполнить fn(i) для каждого i из [0, count) на threads потоках (включая вызывающий)
+    /// \note При threads <= 1 все вызовы выполняются последовательно на вызывающем потоке
+    template <class Fn> void parallelFor(const size_t count, const size_t threads, Fn &&fn)
+    {
+        const size_t workers = std::min(threads, count);
+        if (workers <= 1) {
+            for (size_t i = 0; i < count; ++i) fn(i);
+            return;
+        }
+        std::atomic<size_t> next{0};
+        auto worker = [&] {
+            for (size_t i = next++; i < count; i = next++) fn(i);
+        };
+        std::vector<std::thread> pool;
+        pool.reserve(workers - 1);
+        for (size_t i = 1; i < workers; ++i) pool.emplace_back(worker);
+        worker();
+        for (auto &t : pool) t.join();
+    }
+}
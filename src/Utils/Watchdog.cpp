@@ -0,0 +1,73 @@
+#include "Watchdog.hpp"
+#include "Logger/Log.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace d3156
+{
+    using ms = std::chrono::duration<double, std::milli>;
+
+    Watchdog::Watchdog(const std::chrono::milliseconds timeout) : timeout_(timeout)
+    {
+        if (timeout_.count() > 0) thread_ = std::thread([this] { loop(); });
+    }
+
+    std::chrono::milliseconds Watchdog::timeoutFromEnv(const char *env, const std::chrono::milliseconds def)
+    {
+        if (const char *val = std::getenv(env)) {
+            try {
+                return std::chrono::milliseconds(std::stoul(val));
+            } catch (...) {
+                Y_LOG(0, "Invalid " << env << " value " << val);
+            }
+        }
+        return def;
+    }
+
+    Watchdog::~Watchdog()
+    {
+        if (!thread_.joinable()) return;
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    void Watchdog::loop()
+    {
+        const auto period = std::clamp(timeout_ / 4, std::chrono::milliseconds(1), std::chrono::milliseconds(100));
+        std::unique_lock lock(mutex_);
+        while (!stop_) {
+            cv_.wait_for(lock, period);
+            const auto now = std::chrono::steady_clock::now();
+            for (auto &entry : running_)
+                if (!entry.reported && now - entry.start > timeout_) {
+                    entry.reported = true;
+                    R_LOG(0, entry.name << " is still running after " << ms(now - entry.start).count()
+                                        << " ms (timeout " << timeout_.count() << " ms)");
+                }
+        }
+    }
+
+    Watchdog::Guard::Guard(Watchdog &watchdog, std::string name)
+        : watchdog_(watchdog.thread_.joinable() ? &watchdog : nullptr)
+    {
+        if (!watchdog_) return;
+        std::lock_guard lock(watchdog_->mutex_);
+        entry_ = watchdog_->running_.insert(watchdog_->running_.end(),
+                                            Entry{std::move(name), std::chrono::steady_clock::now()});
+    }
+
+    Watchdog::Guard::~Guard()
+    {
+        if (!watchdog_) return;
+        std::lock_guard lock(watchdog_->mutex_);
+        const auto elapsed = std::chrono::steady_clock::now() - entry_->start;
+        if (elapsed > watchdog_->timeout_)
+            Y_LOG(0, entry_->name << " finished after " << ms(elapsed).count() << " ms (timeout "
+                                  << watchdog_->timeout_.count() << " ms)");
+        watchdog_->running_.erase(entry_);
+    }
+}
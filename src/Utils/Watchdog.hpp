@@ -0,0 +1,58 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace d3156
+{
+    /// \brief Сторож длительных операций: сообщает в лог об операциях, выполняющихся дольше таймаута
+    /// \details Прервать операцию сторож не может, только сообщает о превышении - пока она ещё выполняется
+    /// и по её завершении.
+    class Watchdog
+    {
+    public:
+        /// \param timeout 0 - сторож отключён
+        explicit Watchdog(std::chrono::milliseconds timeout);
+        /// \brief Таймаут из переменной окружения в миллисекундах, не задана - def
+        static std::chrono::milliseconds timeoutFromEnv(const char *env, std::chrono::milliseconds def);
+        ~Watchdog();
+
+        Watchdog(const Watchdog &)            = delete;
+        Watchdog &operator=(const Watchdog &) = delete;
+
+        /// \brief RAII-отметка выполняемой операции
+        class Guard
+        {
+        public:
+            Guard(Watchdog &watchdog, std::string name);
+            ~Guard();
+
+            Guard(const Guard &)            = delete;
+            Guard &operator=(const Guard &) = delete;
+
+        private:
+            struct Entry {
+                std::string name;
+                std::chrono::steady_clock::time_point start;
+                bool reported = false;
+            };
+
+            Watchdog *watchdog_;
+            std::list<Entry>::iterator entry_;
+            friend class Watchdog;
+        };
+
+    private:
+        void loop();
+
+        const std::chrono::milliseconds timeout_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::list<Guard::Entry> running_;
+        bool stop_ = false;
+        std::thread thread_;
+    };
+}
@@ -0,0 +1,97 @@
+/// OUT=BINARY: записи процесса переводятся plog-decode обратно в текст, в том числе после прерванной записи
+#include <Logger/Log.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    int failures = 0;
+
+    void expect(const char *name, const bool ok)
+    {
+        std::printf("%s %s\n", ok ? "ok  " : "FAIL", name);
+        if (!ok) ++failures;
+    }
+
+    int nested(const int value)
+    {
+        G_LOG(0, "nested " << value);
+        return value * 2;
+    }
+
+    std::string decode(const fs::path &segment)
+    {
+        const std::string command = std::string(PLOG_DECODE) + " " + segment.string() + " 2>&1";
+        std::string out;
+        FILE *pipe = popen(command.c_str(), "r");
+        if (pipe == nullptr) return out;
+        char buffer[4096];
+        while (const size_t n = std::fread(buffer, 1, sizeof(buffer), pipe)) out.append(buffer, n);
+        pclose(pipe);
+        return out;
+    }
+
+    /// Обнулить размер записи с сообщением text: так выглядит запись, прерванная между reserve и публикацией
+    bool tear(std::string &data, const std::string &text)
+    {
+        const size_t at = data.find(text);
+        if (at == std::string::npos) return false;
+        uint32_t format_len = 0;
+        std::memcpy(&format_len, data.data() + 8, sizeof(format_len));
+        size_t pos = (12 + format_len + 7) & ~size_t{7};
+        while (pos + 8 <= data.size()) {
+            uint32_t size = 0;
+            std::memcpy(&size, data.data() + pos, sizeof(size));
+            if (size == 0) return false;
+            if (at < pos + size) {
+                std::memset(data.data() + pos, 0, sizeof(size));
+                return true;
+            }
+            pos += size;
+        }
+        return false;
+    }
+}
+
+int main()
+{
+    G_LOG(0, "first " << 42 << ' ' << -7 << ' ' << 2.5 << ' ' << true << " text");
+    G_LOG(0, "outer " << nested(5) << " end");
+    Y_LOG(0, "torn record");
+    for (int i = 0; i < 3; ++i) R_LOG(0, "after " << i);
+    d3156::LoggerManager::flush();
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "binary.%d.00000.plog", static_cast<int>(getpid()));
+    const fs::path segment = fs::path(std::getenv("OUT_DIR")) / name;
+    expect("segment is written", fs::exists(segment));
+
+    const std::string text = decode(segment);
+    std::printf("%s", text.c_str());
+    expect("arguments round-trip", text.find("GREEN_Test first 42 -7 2.5 1 text\n") != std::string::npos);
+    expect("nested record is kept whole",
+           text.find("GREEN_Test nested 5\nGREEN_Test outer 10 end\n") != std::string::npos);
+    expect("all records are decoded", text.find("RED_Test after 2\n") != std::string::npos);
+
+    std::ifstream in(segment, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    const fs::path torn = segment.string() + ".torn.plog";
+    expect("record to tear is found", tear(data, "torn record"));
+    std::ofstream(torn, std::ios::binary) << data;
+    const std::string rest = decode(torn);
+    std::printf("%s", rest.c_str());
+    expect("torn record is skipped", rest.find("torn record") == std::string::npos);
+    expect("records after the torn one are decoded",
+           rest.find("RED_Test after 0\nRED_Test after 1\nRED_Test after 2\n") != std::string::npos);
+    expect("skipped record is reported", rest.find("Skipped 1 incomplete record(s)") != std::string::npos);
+    fs::remove(torn);
+    return failures == 0 ? 0 : 1;
+}
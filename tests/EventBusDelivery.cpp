@@ -0,0 +1,103 @@
+/// EventBus: доставка Inline, Executor и Thread и публикация после остановки пула Core
+#include "TestPlugin.hpp"
+#include <EventBus/EventBus.hpp>
+#include <Executor/Executor.hpp>
+#include <IPlugin.hpp>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+using namespace d3156::PluginCore;
+
+namespace
+{
+    /// Номера событий в порядке получения и поток, в котором они получены
+    struct Received {
+        std::mutex mutex;
+        std::vector<int> values;
+        std::thread::id thread;
+        bool in_worker = false;
+
+        void add(const int value, const Executor *executor)
+        {
+            std::lock_guard lock(mutex);
+            values.push_back(value);
+            thread    = std::this_thread::get_id();
+            in_worker = executor && executor->inWorker();
+        }
+
+        size_t size()
+        {
+            std::lock_guard lock(mutex);
+            return values.size();
+        }
+
+        bool ordered(const int count)
+        {
+            std::lock_guard lock(mutex);
+            if (values.size() != static_cast<size_t>(count)) return false;
+            for (int i = 0; i < count; ++i)
+                if (values[i] != i) return false;
+            return true;
+        }
+    };
+
+    constexpr int events = 1000;
+
+    struct EventBusTest final : IPlugin {
+        EventBus *bus       = nullptr;
+        Executor *executor  = nullptr;
+        Received inline_received, executor_received, thread_received;
+        EventBus::Subscription inline_sub, executor_sub, thread_sub;
+
+        void registerModels(ModelsStorage &models) override
+        {
+            bus      = models.registerModel<EventBus>();
+            executor = models.registerModel<Executor>();
+            inline_sub = bus->subscribe<int>(
+                "test.inline", [this](const int &v) { inline_received.add(v, executor); }, EventBus::Delivery::Inline);
+            executor_sub = bus->subscribe<int>(
+                "test.executor", [this](const int &v) { executor_received.add(v, executor); },
+                EventBus::Delivery::Executor, 2 * events);
+            thread_sub = bus->subscribe<int>(
+                "test.thread", [this](const int &v) { thread_received.add(v, executor); }, EventBus::Delivery::Thread,
+                2 * events);
+        }
+
+        void postInit() override
+        {
+            const auto inline_topic = bus->topic<int>("test.inline");
+            inline_topic.emplace(0);
+            testExpect("inline handler runs in the publishing thread before publish returns",
+                       inline_received.size() == 1 && inline_received.thread == std::this_thread::get_id());
+
+            const auto executor_topic = bus->topic<int>("test.executor");
+            for (int i = 0; i < events; ++i) executor_topic.emplace(i);
+            testExpect("executor subscriber receives every event",
+                       waitFor([&] { return executor_received.size() == events; }));
+            testExpect("executor subscriber receives events in order", executor_received.ordered(events));
+            testExpect("executor subscriber runs in a pool worker", executor_received.in_worker);
+
+            const auto thread_topic = bus->topic<int>("test.thread");
+            for (int i = 0; i < events; ++i) thread_topic.emplace(i);
+            testExpect("thread subscriber receives every event",
+                       waitFor([&] { return thread_received.size() == events; }));
+            testExpect("thread subscriber receives events in order", thread_received.ordered(events));
+            testExpect("thread subscriber runs in its own thread",
+                       thread_received.thread != std::this_thread::get_id() && !thread_received.in_worker);
+        }
+
+        /// Core удаляет плагины после остановки пула: задачи больше не принимаются
+        ~EventBusTest() override
+        {
+            const auto topic = bus->topic<int>("test.executor");
+            for (int i = events; i < events + 10; ++i) topic.emplace(i);
+            testExpect("publish after the executor stops is delivered", executor_received.size() == events + 10);
+            for (int i = events + 10; i < events + 20; ++i) topic.emplace(i);
+            testExpect("subscriber is not stalled by a rejected task", executor_received.ordered(events + 20));
+        }
+    };
+}
+
+extern "C" IPlugin *create_plugin() { return new EventBusTest; }
+extern "C" void destroy_plugin(IPlugin *plugin) { delete plugin; }
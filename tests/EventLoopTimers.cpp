@@ -0,0 +1,49 @@
+/// Таймеры разных уровней колеса: дальние таймеры не должны опаздывать, пока на уровне 0 есть ближние
+#include <EventLoop/EventLoop.hpp>
+#include <chrono>
+#include <cstdio>
+
+using namespace d3156::PluginCore;
+using clock_type = std::chrono::steady_clock;
+
+namespace
+{
+    int failures = 0;
+
+    void expectNear(const char *name, const clock_type::duration fired, const std::chrono::milliseconds expected)
+    {
+        /// Запас на планировщик: опоздание на один цикл переноса уровня (64 мс) заметно больше
+        constexpr std::chrono::milliseconds slack(20);
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(fired);
+        const bool ok = ms >= expected && ms <= expected + slack;
+        std::printf("%s %s: fired at %lld ms, expected %lld ms\n", ok ? "ok  " : "FAIL", name,
+                    static_cast<long long>(ms.count()), static_cast<long long>(expected.count()));
+        if (!ok) ++failures;
+    }
+}
+
+int main()
+{
+    EventLoop::blockSignals();
+    EventLoop loop;
+    loop.init();
+    const auto start = clock_type::now();
+    clock_type::duration far{}, near{}, far_late{}, far_level2{};
+
+    /// Дальний таймер (уровень 1) и ближний, добавленный позже (уровень 0) со сроком позже переноса уровня 1:
+    /// ожидание только до ячейки уровня 0 пропустило бы перенос на 64 мс
+    loop.addTimer(std::chrono::milliseconds(70), [&] { far = clock_type::now() - start; });
+    loop.addTimer(std::chrono::milliseconds(30), [&] {
+        loop.addTimer(std::chrono::milliseconds(60), [&] { near = clock_type::now() - start; });
+    });
+    loop.addTimer(std::chrono::milliseconds(130), [&] { far_late = clock_type::now() - start; });
+    loop.addTimer(std::chrono::milliseconds(4200), [&] { far_level2 = clock_type::now() - start; });
+    loop.addTimer(std::chrono::milliseconds(4300), [&] { loop.stop(); });
+    loop.run();
+
+    expectNear("level 1 timer with level 0 busy", far, std::chrono::milliseconds(70));
+    expectNear("level 0 timer added later", near, std::chrono::milliseconds(90));
+    expectNear("second level 1 timer", far_late, std::chrono::milliseconds(130));
+    expectNear("level 2 timer", far_level2, std::chrono::milliseconds(4200));
+    return failures == 0 ? 0 : 1;
+}
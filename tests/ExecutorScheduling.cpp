@@ -0,0 +1,129 @@
+/// Executor: приоритеты, порядок внешних задач, перехват задач и выполнение поставленных задач при остановке
+#include "TestPlugin.hpp"
+#include <Executor/Executor.hpp>
+#include <IPlugin.hpp>
+#include <atomic>
+#include <mutex>
+#include <set>
+
+using namespace d3156::PluginCore;
+
+namespace
+{
+    struct ExecutorTest final : IPlugin {
+        Executor *executor = nullptr;
+        std::atomic<size_t> blocked{0};
+        std::atomic<bool> release{false};
+        std::atomic<size_t> chained{0};
+        std::atomic<bool> chain_rejected{false};
+        std::atomic<size_t> drained{0};
+
+        void registerModels(ModelsStorage &models) override { executor = models.registerModel<Executor>(); }
+
+        /// Занять все рабочие потоки, чтобы следующие задачи остались в очередях до release
+        bool blockWorkers()
+        {
+            /// Блокирующие задачи прошлой проверки могли ещё не заметить release
+            if (!waitFor([&] { return blocked.load() == 0; })) return false;
+            release = false;
+            for (size_t i = 0; i < executor->threads(); ++i)
+                executor->post([this] {
+                    blocked++;
+                    while (!release.load()) std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    blocked--;
+                });
+            return waitFor([&] { return blocked.load() == executor->threads(); });
+        }
+
+        void priorities()
+        {
+            constexpr size_t count = 200;
+            std::atomic<size_t> high{0}, low{0};
+            std::atomic<bool> overtaken{false};
+            testExpect("workers are blocked before the priority check", blockWorkers());
+            for (size_t i = 0; i < count; ++i) {
+                executor->post(
+                    [&] {
+                        /// Пока задачи High в очередях, Low не берётся; уже взятые High могут ещё не начаться
+                        if (high.load() + executor->threads() < count) overtaken = true;
+                        low++;
+                    },
+                    Executor::Priority::Low);
+                executor->post([&] { high++; }, Executor::Priority::High);
+            }
+            release = true;
+            testExpect("queued tasks of both priorities run", waitFor([&] { return low.load() == count; }));
+            testExpect("High tasks run before queued Low tasks", !overtaken.load() && high.load() == count);
+        }
+
+        void externalOrder()
+        {
+            constexpr size_t count = 4000;
+            std::atomic<size_t> started{0};
+            std::atomic<size_t> before_first{count};
+            testExpect("workers are blocked before the order check", blockWorkers());
+            executor->post([&] { before_first = started++; });
+            for (size_t i = 1; i < count; ++i) executor->post([&] { started++; });
+            release = true;
+            testExpect("externally posted tasks run", waitFor([&] { return started.load() == count; }));
+            testExpect("first externally posted task is not overtaken by later ones",
+                       before_first.load() < count / 4);
+        }
+
+        void stealing()
+        {
+            constexpr size_t count = 100;
+            std::mutex mutex;
+            std::set<std::thread::id> threads;
+            std::atomic<size_t> done{0};
+            /// Задачи ставятся из рабочего потока в его собственную очередь; остальные потоки должны их перехватить
+            executor->post([&] {
+                for (size_t i = 0; i < count; ++i)
+                    executor->post([&] {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                        {
+                            std::lock_guard lock(mutex);
+                            threads.insert(std::this_thread::get_id());
+                        }
+                        done++;
+                    });
+            });
+            testExpect("tasks posted by a worker run", waitFor([&] { return done.load() == count; }));
+            std::lock_guard lock(mutex);
+            testExpect("tasks of one worker are stolen by others", threads.size() > 1);
+        }
+
+        /// Цепочка ставит себя заново, пока пул не перестанет принимать задачи
+        void chain()
+        {
+            chained++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            if (!executor->post([this] { chain(); })) chain_rejected = true;
+        }
+
+        void postInit() override
+        {
+            testExpect("pool has the configured number of workers", executor->threads() == 4);
+            priorities();
+            externalOrder();
+            stealing();
+            executor->post([this] { chain(); });
+            for (size_t i = 0; i < 20; ++i)
+                executor->post([this] {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                    drained++;
+                });
+        }
+
+        /// Core удаляет плагины после остановки пула
+        ~ExecutorTest() override
+        {
+            testExpect("tasks queued before stop are executed", drained.load() == 20);
+            testExpect("tasks posted while stopping are rejected", chained.load() > 0 && chain_rejected.load());
+            testExpect("post after stop is rejected", !executor->post([] {}));
+        }
+    };
+}
+
+extern "C" IPlugin *create_plugin() { return new ExecutorTest; }
+extern "C" void destroy_plugin(IPlugin *plugin) { delete plugin; }
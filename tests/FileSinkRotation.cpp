@@ -0,0 +1,116 @@
+/// RotatingFileSink: ротация по размеру, предел max_total и продолжение файла после аварийного завершения
+#include <Logger/FileSink.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace d3156;
+namespace fs = std::filesystem;
+
+namespace
+{
+    int failures = 0;
+
+    void expect(const char *name, const bool ok)
+    {
+        std::printf("%s %s\n", ok ? "ok  " : "FAIL", name);
+        if (!ok) ++failures;
+    }
+
+    std::string read(const fs::path &path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+
+    std::string line(const size_t i)
+    {
+        std::string out = "line " + std::to_string(i) + " ";
+        out.resize(99, 'x');
+        return out + '\n';
+    }
+
+    void writeLines(RotatingFileSink &sink, const size_t from, const size_t to)
+    {
+        for (size_t i = from; i < to; ++i) {
+            const std::string text = line(i);
+            sink.write(text.data(), text.size(), std::chrono::system_clock::now());
+        }
+    }
+
+    /// Содержимое name.N.log ... name.1.log, name.log в порядке записи
+    std::string readAll(const fs::path &dir, const std::string &name)
+    {
+        size_t last = 0;
+        while (fs::exists(dir / (name + "." + std::to_string(last + 1) + ".log"))) ++last;
+        std::string out;
+        for (size_t i = last; i > 0; --i) out += read(dir / (name + "." + std::to_string(i) + ".log"));
+        return out + read(dir / (name + ".log"));
+    }
+}
+
+int main()
+{
+    char tmpl[] = "/tmp/PluginCore_test_file_sink.XXXXXX";
+    if (mkdtemp(tmpl) == nullptr) return 1;
+    const fs::path dir = tmpl;
+    FileSinkOptions options;
+    options.segment_size = 4096;
+
+    {
+        RotatingFileSink sink(dir, "rotate", options);
+        writeLines(sink, 0, 200);
+    }
+    std::string expected;
+    for (size_t i = 0; i < 200; ++i) expected += line(i);
+    const std::string all = readAll(dir, "rotate");
+    expect("rotated files keep every line in order", all == expected);
+    expect("rotated files contain no NUL", all.find('\0') == std::string::npos);
+    bool within = true;
+    for (const auto &entry : fs::directory_iterator(dir))
+        if (entry.path().filename().string().starts_with("rotate")) within = within && fs::file_size(entry) <= 4096;
+    expect("every file fits in a segment", within);
+
+    options.max_total = 3 * 4096;
+    {
+        RotatingFileSink sink(dir, "capped", options);
+        writeLines(sink, 0, 400);
+    }
+    size_t archived = 0;
+    for (const auto &entry : fs::directory_iterator(dir)) {
+        const std::string file = entry.path().filename().string();
+        if (file.starts_with("capped.") && file != "capped.log") archived += fs::file_size(entry);
+    }
+    expect("archived files stay within max_total", archived > 0 && archived <= options.max_total);
+    const std::string tail = readAll(dir, "capped");
+    expect("newest lines are kept", tail.ends_with(line(399)));
+    options.max_total = 0;
+
+    /// Процесс, убитый без деструкторов, оставляет файл полного размера с нулевым хвостом
+    const pid_t child = fork();
+    if (child == 0) {
+        auto *sink = new RotatingFileSink(dir, "crash", options);
+        writeLines(*sink, 0, 10);
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    expect("unclean file has a zero tail", fs::file_size(dir / "crash.log") == 4096);
+    {
+        RotatingFileSink sink(dir, "crash", options);
+        writeLines(sink, 10, 12);
+    }
+    expected.clear();
+    for (size_t i = 0; i < 12; ++i) expected += line(i);
+    expect("reopened file continues after the last line", read(dir / "crash.log") == expected);
+    expect("reopening does not rotate the zero tail", !fs::exists(dir / "crash.1.log"));
+
+    fs::remove_all(dir);
+    return failures == 0 ? 0 : 1;
+}
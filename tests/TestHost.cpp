@@ -0,0 +1,28 @@
+/// Хост тестов моделей Core: Core загружает тестовый плагин из TEST_PLUGIN_DIR, плагин проверяет модели в
+/// postInit и при удалении (после остановки пула). Число неудачных проверок - код возврата
+#include "TestPlugin.hpp"
+#include <Core.hpp>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    int failures = 0;
+}
+
+extern "C" void testExpect(const char *name, const bool ok)
+{
+    std::printf("%s %s\n", ok ? "ok  " : "FAIL", name);
+    std::fflush(stdout);
+    if (!ok) ++failures;
+}
+
+int main(int argc, char *argv[])
+{
+    setenv("PLUGINS_DIR", TEST_PLUGIN_DIR, 1);
+    setenv("PLUGINS_MANIFEST", "", 1);
+    {
+        d3156::PluginCore::Core core(argc, argv);
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <chrono>
+#include <thread>
+
+/// \brief Результат проверки: реализован хостом тестов (TestHost.cpp), плагин находит его при загрузке
+extern "C" void testExpect(const char *name, bool ok);
+
+/// \brief Ждать выполнения условия не дольше timeout
+/// \return Значение условия при выходе
+template <class Condition>
+bool waitFor(Condition condition, const std::chrono::milliseconds timeout = std::chrono::milliseconds(5000))
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}